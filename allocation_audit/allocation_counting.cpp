@@ -0,0 +1,36 @@
+#include <allocation_counting.hpp>
+
+#include <cstdlib>
+#include <new>
+
+static thread_local std::size_t the_allocation_count = 0;
+
+std::size_t
+allocation_count()
+{
+    return the_allocation_count;
+}
+
+void*
+operator new(std::size_t size)
+{
+    ++the_allocation_count;
+    if (size == 0)
+        size = 1;
+    void* storage = std::malloc(size);
+    if (!storage)
+        throw std::bad_alloc();
+    return storage;
+}
+
+void
+operator delete(void* storage) noexcept
+{
+    std::free(storage);
+}
+
+void
+operator delete(void* storage, std::size_t) noexcept
+{
+    std::free(storage);
+}
@@ -0,0 +1,34 @@
+#ifndef ALIA_ALLOCATION_AUDIT_ALLOCATION_COUNTING_HPP
+#define ALIA_ALLOCATION_AUDIT_ALLOCATION_COUNTING_HPP
+
+#include <cstddef>
+
+// The allocation audit runner replaces the global operator new so that tests
+// can check how many heap allocations a piece of code performs. (This is kept
+// out of the normal unit test runner so that the other tests aren't affected
+// by it.)
+// Only allocations made on the calling thread are counted.
+
+// Get the number of heap allocations that have been made on this thread.
+std::size_t
+allocation_count();
+
+// allocation_counter counts the heap allocations made on this thread over
+// its lifetime.
+struct allocation_counter
+{
+    allocation_counter() : start_(allocation_count())
+    {
+    }
+
+    std::size_t
+    count() const
+    {
+        return allocation_count() - start_;
+    }
+
+ private:
+    std::size_t start_;
+};
+
+#endif
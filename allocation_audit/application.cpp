@@ -0,0 +1,82 @@
+#include <alia/signals/application.hpp>
+
+#include <alia/flow/macros.hpp>
+#include <alia/signals/basic.hpp>
+
+#include <vector>
+
+#include <allocation_counting.hpp>
+#include <testing.hpp>
+#include <traversal.hpp>
+
+using namespace alia;
+
+TEST_CASE("apply ID allocations", "[allocation_audit][signals]")
+{
+    alia::system sys;
+    initialize_system(sys, [](context) {});
+
+    std::size_t apply_allocations = 0;
+    auto make_controller = [&](bool active, int x) {
+        return [=, &apply_allocations](context ctx) {
+            ALIA_IF(active)
+            {
+                allocation_counter allocations;
+                auto s = apply(
+                    ctx,
+                    [](int x, int y) { return x + y; },
+                    value(x),
+                    value(1));
+                REQUIRE(read_signal(s) == x + 1);
+                apply_allocations += allocations.count();
+            }
+            ALIA_END
+        };
+    };
+
+    // The first pass allocates the data nodes themselves.
+    do_traversal(sys, make_controller(true, 0));
+
+    // After that, neither changing the arguments nor clearing out the cached
+    // argument IDs (by deactivating the block) should allocate anything.
+    apply_allocations = 0;
+    for (int i = 1; i != 10; ++i)
+    {
+        do_traversal(sys, make_controller(true, i));
+        do_traversal(sys, make_controller(true, i));
+        do_traversal(sys, make_controller(false, i));
+    }
+    REQUIRE(apply_allocations == 0);
+}
+
+TEST_CASE("apply_into allocations", "[allocation_audit][signals]")
+{
+    auto f = [](std::vector<int>& result, int n, int x) {
+        result.clear();
+        for (int i = 0; i != n; ++i)
+            result.push_back(x + i);
+    };
+
+    alia::system sys;
+    initialize_system(sys, [](context) {});
+
+    std::size_t allocations = 0;
+    auto make_controller = [&](int n, int x) {
+        return [=, &allocations](context ctx) {
+            allocation_counter counter;
+            auto s = apply_into<std::vector<int>>(ctx, f, value(n), value(x));
+            allocations += counter.count();
+            REQUIRE(read_signal(s).size() == std::size_t(n));
+        };
+    };
+
+    // The first pass allocates the data node and the initial result.
+    do_traversal(sys, make_controller(8, 0));
+
+    // Recomputing reuses the previous result's storage, so it doesn't
+    // allocate.
+    allocations = 0;
+    for (int x = 1; x != 10; ++x)
+        do_traversal(sys, make_controller(x % 8, x));
+    REQUIRE(allocations == 0);
+}
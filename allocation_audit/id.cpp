@@ -0,0 +1,63 @@
+#include <alia/id.hpp>
+
+#include <allocation_counting.hpp>
+#include <testing.hpp>
+
+using namespace alia;
+
+TEST_CASE("captured_id inline allocations", "[allocation_audit][id]")
+{
+    int x = 2;
+    bool copies_match = false;
+    allocation_counter allocations;
+    {
+        captured_id c(make_id(0));
+        c.capture(make_id(1));
+        c.capture(make_id(&x));
+        c.capture(combine_ids(make_id(1), make_id(2u)));
+        c.capture(make_id_by_reference(x));
+        c.capture(unit_id);
+
+        // Copying and moving inline IDs shouldn't allocate either.
+        captured_id d = c;
+        captured_id e = std::move(d);
+        d = c;
+        swap(d, e);
+        copies_match = d == c && e == c;
+    }
+    REQUIRE(allocations.count() == 0);
+    REQUIRE(copies_match);
+}
+
+TEST_CASE("ID tuple capture allocations", "[allocation_audit][id]")
+{
+    // This is the sort of ID that pure components capture.
+    int a = 0;
+    unsigned b = 1;
+    auto check_capture = [&](captured_id& c) {
+        auto id0 = make_id(&a);
+        auto id1 = make_id(a);
+        auto id2 = make_id(b);
+        auto id3 = make_id_by_reference(a);
+        auto id4 = combine_ids(make_id(a), make_id(b));
+        auto id5 = make_id(12);
+        auto content_id = combine_ids(
+            ref(id0), ref(id1), ref(id2), ref(id3), ref(id4), ref(id5));
+        c.capture(content_id);
+        REQUIRE(c.matches(content_id));
+    };
+
+    captured_id c;
+    check_capture(c);
+
+    // Once the ID has been captured, recapturing it with different values
+    // shouldn't require any allocations.
+    allocation_counter allocations;
+    for (int i = 0; i != 10; ++i)
+    {
+        a = i;
+        b = unsigned(i * 2);
+        check_capture(c);
+    }
+    REQUIRE(allocations.count() == 0);
+}
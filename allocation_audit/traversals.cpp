@@ -0,0 +1,141 @@
+#include <alia/context/interface.hpp>
+#include <alia/flow/content_caching.hpp>
+#include <alia/flow/events.hpp>
+#include <alia/flow/for_each.hpp>
+#include <alia/flow/macros.hpp>
+#include <alia/flow/try_catch.hpp>
+#include <alia/signals/application.hpp>
+#include <alia/signals/basic.hpp>
+#include <alia/signals/operators.hpp>
+#include <alia/signals/state.hpp>
+#include <alia/system/interface.hpp>
+
+#include <allocation_counting.hpp>
+#include <testing.hpp>
+
+// These tests audit the heap allocations that alia performs during
+// steady-state traversals (i.e., traversals where nothing has changed since
+// the last one). Once the data graph has been populated, these shouldn't
+// touch the heap at all.
+
+using namespace alia;
+
+namespace {
+
+struct theme
+{
+    int color = 0;
+};
+ALIA_DEFINE_TAGGED_TYPE(theme_tag, theme&)
+
+struct audit_event
+{
+    int visits = 0;
+};
+
+// This is meant to exercise all the core mechanisms that are involved in a
+// typical refresh.
+void
+audited_controller(context vanilla_ctx, theme& the_theme)
+{
+    auto ctx = extend_context<theme_tag>(vanilla_ctx, the_theme);
+
+    auto count = get_state(ctx, 4);
+
+    ALIA_IF(count > 2)
+    {
+        auto doubled = apply(ctx, [](int x) { return x * 2; }, count);
+        on_value_change(ctx, doubled, actions::noop());
+    }
+    ALIA_ELSE
+    {
+        get_state(ctx, std::string("placeholder"));
+    }
+    ALIA_END
+
+    ALIA_FOR(int i = 0; i != read_signal(count); ++i)
+    {
+        get_state(ctx, i);
+    }
+    ALIA_END
+
+    {
+        naming_context nc(ctx);
+        for (int i = 0; i != read_signal(count); ++i)
+        {
+            named_block nb(nc, make_id(i));
+            auto label = apply(
+                ctx,
+                [](int i, std::string const& suffix) {
+                    return std::to_string(i) + suffix;
+                },
+                value(i),
+                value(std::string(" items")));
+            on_value_change(ctx, label, actions::noop());
+        }
+    }
+
+    for_each(
+        ctx, apply(ctx, [](int n) { return std::vector<int>(n, 1); }, count),
+        [&](auto item) { get_state(ctx, item); });
+
+    invoke_pure_component(
+        ctx,
+        [&](auto ctx, auto n) {
+            get<theme_tag>(ctx).color += 0;
+            get_state(ctx, n);
+        },
+        count);
+
+    ALIA_TRY
+    {
+        refresh_handler(ctx, [&](auto) {});
+        event_handler<audit_event>(
+            ctx, [&](auto, audit_event& e) { ++e.visits; });
+    }
+    ALIA_CATCH(...)
+    {
+    }
+    ALIA_END
+}
+
+} // namespace
+
+TEST_CASE("steady-state refresh allocations", "[allocation_audit]")
+{
+    theme the_theme;
+    alia::system sys;
+    initialize_system(
+        sys, [&](context ctx) { audited_controller(ctx, the_theme); });
+
+    // Populate the data graph.
+    refresh_system(sys);
+    refresh_system(sys);
+
+    for (int i = 0; i != 4; ++i)
+    {
+        allocation_counter allocations;
+        refresh_system(sys);
+        REQUIRE(allocations.count() == 0);
+    }
+}
+
+TEST_CASE("steady-state event allocations", "[allocation_audit]")
+{
+    theme the_theme;
+    alia::system sys;
+    initialize_system(
+        sys, [&](context ctx) { audited_controller(ctx, the_theme); });
+
+    refresh_system(sys);
+    refresh_system(sys);
+
+    for (int i = 0; i != 4; ++i)
+    {
+        audit_event event;
+        allocation_counter allocations;
+        dispatch_event(sys, event);
+        REQUIRE(allocations.count() == 0);
+        REQUIRE(event.visits == 1);
+    }
+}
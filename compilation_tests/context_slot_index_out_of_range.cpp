@@ -0,0 +1,11 @@
+#include <alia/context/interface.hpp>
+
+struct foo
+{
+};
+ALIA_DEFINE_TAGGED_TYPE(foo_tag, foo&)
+#ifdef ALIA_TEST_COMPILATION_FAILURE
+ALIA_ADD_CONTEXT_SLOT(foo_tag, alia::context_storage::slot_count)
+#else
+ALIA_ADD_CONTEXT_SLOT(foo_tag, alia::context_storage::slot_count - 1)
+#endif
@@ -0,0 +1,17 @@
+#include <alia/context/interface.hpp>
+
+struct foo
+{
+};
+ALIA_DEFINE_TAGGED_TYPE(foo_tag, foo&)
+ALIA_ADD_CONTEXT_SLOT(foo_tag, 0)
+
+struct bar
+{
+};
+ALIA_DEFINE_TAGGED_TYPE(bar_tag, bar&)
+#ifdef ALIA_TEST_COMPILATION_FAILURE
+ALIA_ADD_CONTEXT_SLOT(bar_tag, 0)
+#else
+ALIA_ADD_CONTEXT_SLOT(bar_tag, 1)
+#endif
@@ -31,6 +31,11 @@ struct context_storage
     data_traversal* data = nullptr;
     timing_subsystem* timing = nullptr;
 
+    // direct storage for application-defined objects
+    // (See ALIA_ADD_CONTEXT_SLOT below.)
+    static constexpr std::size_t slot_count = 8;
+    void* slots[slot_count] = {};
+
     // generic storage for other objects
     detail::generic_tagged_storage<std::any> generic;
 
@@ -45,6 +50,34 @@ ALIA_ADD_DIRECT_TAGGED_DATA_ACCESS(context_storage, event_traversal_tag, event)
 ALIA_ADD_DIRECT_TAGGED_DATA_ACCESS(context_storage, data_traversal_tag, data)
 ALIA_ADD_DIRECT_TAGGED_DATA_ACCESS(context_storage, timing_tag, timing)
 
+} // namespace alia
+
+// Objects that are added to the context with application-defined tags are
+// stored generically by default, which means that accessing them requires a
+// search through the generic storage and an any_cast. If you access an object
+// frequently (e.g., in per-item code), you can give its tag one of the direct
+// storage slots in context_storage instead, which makes get<Tag>(ctx) just a
+// pointer dereference:
+//
+//   ALIA_ADD_CONTEXT_SLOT(my_app::theme_tag, 0)
+//
+// This must be invoked at global scope with a fully qualified tag name, and
+// before any code that uses the tag. Only tags with reference data types can
+// be given slots.
+//
+// The slot index is fixed at the declaration. It must be less than
+// context_storage::slot_count (which is checked at compile time) and should be
+// unique within the application. If the same index is given to two tags within
+// one translation unit, that's also a compile-time error. (Libraries that want
+// slots should let the application choose their indices.)
+//
+#define ALIA_ADD_CONTEXT_SLOT(Tag, index)                                     \
+    namespace alia {                                                          \
+    ALIA_ADD_SLOTTED_TAGGED_DATA_ACCESS(context_storage, Tag, index)          \
+    }
+
+namespace alia {
+
 // the context interface wrapper
 template<class Contents>
 struct context_interface
@@ -187,6 +220,13 @@ make_context(
     data_traversal& data,
     timing_subsystem& timing);
 
+// copy_context(ctx) creates a copy of :ctx with its own storage, so that
+// objects can be added to it without affecting :ctx.
+//
+// Note that the generic objects in the new storage are linked to those of
+// :ctx rather than copied, so the copy must NOT outlive :ctx. (This is a
+// change from earlier versions of alia, where the copy was independent.)
+//
 template<class Context>
 Context
 copy_context(Context ctx)
@@ -194,7 +234,19 @@ copy_context(Context ctx)
     context_storage* new_storage;
     get_data(ctx, &new_storage);
 
-    *new_storage = *ctx.contents_.storage;
+    context_storage& parent = *ctx.contents_.storage;
+    // The directly stored objects are just pointers, so they're copied, but
+    // the generic objects are linked rather than copied, so this doesn't
+    // depend on how many objects the context carries. (Note that link_to()
+    // also clears out whatever the storage held on the last pass.)
+    new_storage->sys = parent.sys;
+    new_storage->event = parent.event;
+    new_storage->data = parent.data;
+    new_storage->timing = parent.timing;
+    for (std::size_t i = 0; i != context_storage::slot_count; ++i)
+        new_storage->slots[i] = parent.slots[i];
+    new_storage->generic.link_to(&parent.generic);
+    new_storage->content_id = parent.content_id;
 
     return Context(typename Context::contents_type(new_storage));
 }
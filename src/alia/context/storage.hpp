@@ -2,9 +2,10 @@
 #define ALIA_CONTEXT_STORAGE_HPP
 
 #include <any>
+#include <stdexcept>
 #include <type_traits>
-#include <typeindex>
-#include <unordered_map>
+#include <typeinfo>
+#include <vector>
 
 #include <alia/context/structural_typing.hpp>
 
@@ -13,40 +14,164 @@ namespace alia { namespace detail {
 // generic_tagged_storage is one possible implementation of the underlying
 // container for storing the actual data associated with a tag.
 // :Data is the type used to the store data.
+//
+// Contexts are extended on every traversal, so rather than copying all their
+// objects, an extended storage can be linked to its parent (see link_to()).
+// It then only holds the objects that were added (or removed) at its level,
+// and lookups walk up the chain of parents.
+//
+// Each level rarely holds more than a handful of objects, so they're kept in
+// a small inline array (searched linearly) and only spill over onto the heap
+// when there are more than that.
+//
 template<class Data>
 struct generic_tagged_storage
 {
-    std::unordered_map<std::type_index, Data> objects;
+    // the number of objects that can be stored without heap allocation
+    static constexpr std::size_t inline_capacity = 8;
+
+    // Clear this storage and link it to :parent, so that it initially has all
+    // the same objects as :parent (without copying them).
+    void
+    link_to(generic_tagged_storage* parent)
+    {
+        for (std::size_t i = 0; i != inline_count_; ++i)
+            inline_[i] = entry();
+        inline_count_ = 0;
+        overflow_.clear();
+        parent_ = parent;
+    }
 
     template<class Tag>
     bool
     has() const
     {
-        return this->objects.find(std::type_index(typeid(Tag)))
-               != this->objects.end();
+        return this->lookup(typeid(Tag)) != nullptr;
     }
 
     template<class Tag, class ObjectData>
     void
     add(ObjectData&& data)
     {
-        this->objects[std::type_index(typeid(Tag))]
-            = std::forward<ObjectData&&>(data);
+        std::type_info const& type = typeid(Tag);
+        if (entry* existing = this->find_local(type))
+        {
+            existing->data = std::forward<ObjectData&&>(data);
+            existing->present = true;
+        }
+        else
+        {
+            this->push(type, std::forward<ObjectData&&>(data));
+        }
     }
 
     template<class Tag>
     void
     remove()
     {
-        this->objects.erase(std::type_index(typeid(Tag)));
+        std::type_info const& type = typeid(Tag);
+        entry* e = this->find_local(type);
+        // If a parent still has the object, we have to record its removal
+        // here to hide it.
+        if (parent_ && parent_->lookup(type))
+        {
+            if (!e)
+                e = &this->push(type, Data());
+            e->data = Data();
+            e->present = false;
+            return;
+        }
+        if (!e)
+            return;
+        // Fill the hole with the last entry.
+        if (!overflow_.empty())
+        {
+            *e = std::move(overflow_.back());
+            overflow_.pop_back();
+        }
+        else
+        {
+            entry& last = inline_[--inline_count_];
+            if (e != &last)
+                *e = std::move(last);
+            last = entry();
+        }
     }
 
     template<class Tag>
     Data&
     get()
     {
-        return this->objects.at(std::type_index(typeid(Tag)));
+        entry* e = this->lookup(typeid(Tag));
+        if (!e)
+            throw std::out_of_range("alia: tagged data not found");
+        return e->data;
+    }
+
+ private:
+    struct entry
+    {
+        std::type_info const* type = nullptr;
+        Data data = Data();
+        // If this is false, the entry records the removal of the object.
+        bool present = true;
+    };
+
+    template<class ObjectData>
+    entry&
+    push(std::type_info const& type, ObjectData&& data)
+    {
+        if (inline_count_ != inline_capacity)
+        {
+            entry& e = inline_[inline_count_++];
+            e.type = &type;
+            e.data = std::forward<ObjectData&&>(data);
+            e.present = true;
+            return e;
+        }
+        overflow_.push_back(
+            entry{&type, std::forward<ObjectData&&>(data), true});
+        return overflow_.back();
+    }
+
+    // Find the entry for :type at this level.
+    entry*
+    find_local(std::type_info const& type)
+    {
+        for (std::size_t i = 0; i != inline_count_; ++i)
+        {
+            if (*inline_[i].type == type)
+                return &inline_[i];
+        }
+        for (auto& e : overflow_)
+        {
+            if (*e.type == type)
+                return &e;
+        }
+        return nullptr;
     }
+
+    // Find the object for :type at this level or above.
+    entry*
+    lookup(std::type_info const& type)
+    {
+        for (generic_tagged_storage* s = this; s; s = s->parent_)
+        {
+            if (entry* e = s->find_local(type))
+                return e->present ? e : nullptr;
+        }
+        return nullptr;
+    }
+    entry const*
+    lookup(std::type_info const& type) const
+    {
+        return const_cast<generic_tagged_storage&>(*this).lookup(type);
+    }
+
+    entry inline_[inline_capacity];
+    std::size_t inline_count_ = 0;
+    std::vector<entry> overflow_;
+    generic_tagged_storage* parent_ = nullptr;
 };
 
 template<class T>
@@ -151,6 +276,61 @@ struct tagged_data_accessor
     };                                                                        \
     }
 
+// ALIA_ADD_SLOTTED_TAGGED_DATA_ACCESS(Storage, Tag, index) is similar, but
+// rather than requiring a dedicated member in :Storage, it stores a pointer to
+// the data in the :index'th entry of Storage's 'slots' array. This allows
+// tags to be given direct storage without modifying :Storage itself.
+//
+// The index is fixed at compile time, so accessing the data is a direct array
+// access. Only tags with reference data types can be stored this way, and each
+// slot can only be assigned to one tag. (Assigning the same slot twice within
+// a translation unit is a compile-time error, but indices must also be kept
+// unique across translation units.)
+//
+template<class Storage, std::size_t Index>
+struct tagged_data_slot_owner;
+
+#define ALIA_ADD_SLOTTED_TAGGED_DATA_ACCESS(Storage, Tag, index)              \
+    namespace detail {                                                        \
+    template<>                                                                \
+    struct tagged_data_slot_owner<Storage, index>                             \
+    {                                                                         \
+        typedef Tag tag;                                                      \
+    };                                                                        \
+    template<>                                                                \
+    struct tagged_data_accessor<Storage, Tag>                                 \
+    {                                                                         \
+        static_assert(                                                        \
+            std::is_reference<Tag::data_type>::value,                         \
+            "only reference tags can be given direct storage slots");         \
+        static_assert(                                                        \
+            (index) < Storage::slot_count,                                    \
+            "storage slot index out of range");                               \
+        typedef std::remove_reference_t<Tag::data_type> object_type;          \
+        static bool                                                           \
+        has(Storage const& storage)                                           \
+        {                                                                     \
+            return storage.slots[index] != nullptr;                           \
+        }                                                                     \
+        static void                                                           \
+        add(Storage& storage, Tag::data_type data)                            \
+        {                                                                     \
+            storage.slots[index]                                              \
+                = const_cast<void*>(static_cast<void const*>(&data));         \
+        }                                                                     \
+        static void                                                           \
+        remove(Storage& storage)                                              \
+        {                                                                     \
+            storage.slots[index] = nullptr;                                   \
+        }                                                                     \
+        static Tag::data_type                                                 \
+        get(Storage& storage)                                                 \
+        {                                                                     \
+            return *static_cast<object_type*>(storage.slots[index]);          \
+        }                                                                     \
+    };                                                                        \
+    }
+
 }} // namespace alia::detail
 
 #endif
@@ -1,11 +1,45 @@
 #include <alia/flow/components.hpp>
 #include <alia/flow/events.hpp>
+#include <alia/system/internals.hpp>
+
+#include <algorithm>
 
 namespace alia {
 
+component_reentry_point::~component_reentry_point()
+{
+    if (container)
+        container->reentry = nullptr;
+    if (sys)
+    {
+        auto& pending = sys->pending_reentries;
+        std::replace(
+            pending.begin(),
+            pending.end(),
+            this,
+            static_cast<component_reentry_point*>(nullptr));
+    }
+}
+
+// Record that the isolated component containing :container (or the root
+// component, if there is none) needs to be refreshed.
+static void
+request_component_reentry(component_container* c)
+{
+    while (c && !c->reentry && c->parent)
+        c = c->parent.get();
+    if (c && !c->reentry_needed)
+    {
+        c->reentry_needed = true;
+        if (c->reentry)
+            c->reentry->sys->pending_reentries.push_back(c->reentry);
+    }
+}
+
 void
 mark_dirty_component(component_container_ptr const& container)
 {
+    request_component_reentry(container.get());
     component_container* c = container.get();
     while (c && !c->dirty)
     {
@@ -24,6 +58,7 @@ mark_dirty_component(dataless_context ctx)
 void
 mark_animating_component(component_container_ptr const& container)
 {
+    request_component_reentry(container.get());
     component_container* r = container.get();
     while (r && !r->animating)
     {
@@ -66,7 +101,10 @@ scoped_component_container::begin(
     is_animating_ = (*container)->animating;
     (*container)->animating = false;
 
-    if (traversal.targeted)
+    // Once the traversal has been aborted, nothing else is on its route.
+    if (traversal.aborted)
+        is_on_route_ = false;
+    else if (traversal.targeted)
     {
         if (traversal.path_to_target
             && traversal.path_to_target->node == container->get())
@@ -6,10 +6,14 @@
 
 namespace alia {
 
+struct system;
+
 struct component_container;
 
 typedef std::shared_ptr<component_container> component_container_ptr;
 
+struct component_reentry_point;
+
 struct component_container
 {
     component_container_ptr parent;
@@ -17,6 +21,31 @@ struct component_container
     bool dirty = false;
     // The component is animating and would like to be refreshed soon.
     bool animating = false;
+    // If this is the container of an isolated component, this is the
+    // component's re-entry point. (See invoke_isolated_component.)
+    component_reentry_point* reentry = nullptr;
+    // Something within this isolated component (or, for the root container,
+    // something outside of any isolated component) has changed, so it needs
+    // to be refreshed.
+    bool reentry_needed = false;
+};
+
+// component_reentry_point is the interface to the re-entry point of an
+// isolated component. It allows the component to be refreshed on its own
+// (without running the rest of the controller).
+struct component_reentry_point
+{
+    virtual ~component_reentry_point();
+
+    // Refresh the component within :ctx.
+    virtual void
+    reenter(context ctx)
+        = 0;
+
+    // the system that the component belongs to
+    system* sys = nullptr;
+    // the component's container
+    component_container_ptr container;
 };
 
 void
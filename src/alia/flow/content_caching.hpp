@@ -5,6 +5,7 @@
 #include <alia/flow/components.hpp>
 #include <alia/flow/data_graph.hpp>
 #include <alia/flow/events.hpp>
+#include <alia/system/internals.hpp>
 
 namespace alia {
 
@@ -20,7 +21,12 @@ struct component_caching_data
     data_block context_setup_block;
     data_block content_block;
     component_container_ptr container;
+    // the ID of the content as of the last traversal - Note that this also
+    // caches the hash of the ID, which serves as a fingerprint of the content.
     captured_id content_id;
+    // Is the above fingerprint meaningful? (See
+    // id_interface::hash_is_meaningful.) If not, it's never trusted.
+    bool content_fingerprint_is_meaningful = false;
     std::exception_ptr exception;
 };
 
@@ -50,9 +56,35 @@ invoke_pure_component(Context ctx, Component&& component, Args&&... args)
         // component.
         auto content_id
             = combine_ids(ref(get_content_id(ctx)), ref(args.value_id())...);
-        // And check if it still matches.
-        if (!data->content_id.matches(content_id))
+        // And check if it still matches. When both the stored ID and the new
+        // one have meaningful fingerprints (hashes), those are compared first
+        // so that most changes are detected without a full (virtual,
+        // recursive) comparison of the IDs. If the fingerprints match, the
+        // IDs are compared in full unless the system is configured to trust
+        // the fingerprints. IDs without meaningful fingerprints are always
+        // compared in full.
+        std::size_t const content_fingerprint = content_id.hash();
+        bool const fingerprint_is_meaningful = content_id.hash_is_meaningful();
+        bool const fingerprints_are_comparable
+            = fingerprint_is_meaningful
+              && data->content_fingerprint_is_meaningful;
+        if (!data->content_id.is_initialized())
+        {
+            content_traversal_required = true;
+        }
+        else if (
+            fingerprints_are_comparable
+            && data->content_id.hash() != content_fingerprint)
+        {
             content_traversal_required = true;
+        }
+        else if (
+            !(fingerprints_are_comparable
+              && get<system_tag>(ctx).trust_content_fingerprints)
+            && !(*data->content_id == content_id))
+        {
+            content_traversal_required = true;
+        }
 
         // If the component code is generating an exception and we have no
         // reason to revisit it, just rethrow the exception.
@@ -88,7 +120,10 @@ invoke_pure_component(Context ctx, Component&& component, Args&&... args)
                     // Note that even a captured exception is considered a
                     // "successful" traversal because we know that the
                     // component is currently just generating that exception.
-                    data->content_id.capture(content_id);
+                    data->content_id.capture(
+                        content_id, content_fingerprint);
+                    data->content_fingerprint_is_meaningful
+                        = fingerprint_is_meaningful;
                     try
                     {
                         invoke_content();
@@ -1,9 +1,125 @@
 #include <alia/flow/data_graph.hpp>
-#include <map>
+#include <typeinfo>
 #include <vector>
 
 namespace alia {
 
+struct heap_data_node_allocator : data_node_allocator
+{
+    void*
+    allocate(std::size_t size) override
+    {
+        return ::operator new(size);
+    }
+
+    void
+    deallocate(void* storage, std::size_t) noexcept override
+    {
+        ::operator delete(storage);
+    }
+};
+
+data_node_allocator&
+get_heap_data_node_allocator()
+{
+    static heap_data_node_allocator the_allocator;
+    return the_allocator;
+}
+
+pooled_data_node_allocator::~pooled_data_node_allocator()
+{
+    slab* s = slabs_;
+    while (s)
+    {
+        slab* next = s->next;
+        ::operator delete(s);
+        s = next;
+    }
+}
+
+void*
+pooled_data_node_allocator::allocate(std::size_t size)
+{
+    std::size_t size_class = (size + granularity - 1) / granularity;
+    // Oversized nodes just go to the heap.
+    if (size_class > size_class_count)
+        return ::operator new(size);
+
+    // Zero-sized requests still get their own storage.
+    if (size_class == 0)
+        size_class = 1;
+
+    // If there's a released node of the right size, reuse it.
+    free_block*& free_list = free_lists_[size_class - 1];
+    if (free_list)
+    {
+        free_block* block = free_list;
+        free_list = block->next;
+        return block;
+    }
+
+    // Otherwise, carve a new one out of the current slab (after acquiring a
+    // new slab if necessary).
+    std::size_t const block_size = size_class * granularity;
+    if (std::size_t(slab_end_ - slab_cursor_) < block_size)
+    {
+        // Any space left at the end of the old slab is simply abandoned.
+        // (It's always less than the size of the largest size class.)
+        std::size_t const slab_size = 16384;
+        // The slab header takes up a full unit so that the nodes remain
+        // properly aligned.
+        static_assert(sizeof(slab) <= granularity);
+        slab* new_slab = static_cast<slab*>(::operator new(slab_size));
+        new_slab->next = slabs_;
+        slabs_ = new_slab;
+        slab_cursor_ = reinterpret_cast<char*>(new_slab) + granularity;
+        slab_end_ = reinterpret_cast<char*>(new_slab) + slab_size;
+        reserved_bytes_ += slab_size;
+    }
+    void* block = slab_cursor_;
+    slab_cursor_ += block_size;
+    return block;
+}
+
+void
+pooled_data_node_allocator::deallocate(
+    void* storage, std::size_t size) noexcept
+{
+    std::size_t size_class = (size + granularity - 1) / granularity;
+    if (size_class > size_class_count)
+    {
+        ::operator delete(storage);
+        return;
+    }
+    if (size_class == 0)
+        size_class = 1;
+    free_block* block = static_cast<free_block*>(storage);
+    free_block*& free_list = free_lists_[size_class - 1];
+    block->next = free_list;
+    free_list = block;
+}
+
+// Destroy a data node and release its storage (via whatever mechanism was
+// used to allocate it).
+static void
+destroy_data_node(data_node* node)
+{
+    data_node_allocator* allocator = node->alia_allocator_;
+    if (allocator)
+    {
+        std::size_t size = node->alia_allocation_size_;
+        // The node may not be at the start of its storage, so get a pointer
+        // to the complete object before destroying it.
+        void* storage = dynamic_cast<void*>(node);
+        node->~data_node();
+        allocator->deallocate(storage, size);
+    }
+    else
+    {
+        delete node;
+    }
+}
+
 struct named_block_node
 {
     // the actual data block used for the content
@@ -53,20 +169,241 @@ append_to_list(
     tail = new_node;
 }
 
+// named_block_table is the container that maps IDs to named blocks.
+//
+// Most naming contexts only ever see a handful of names, so the table starts
+// out as a small inline array that's searched linearly (without any heap
+// allocation). If it outgrows that, it switches over to an open-addressing
+// hash table (with linear probing) that's keyed on the hashes of the IDs.
+//
+// The table owns the nodes themselves, which are allocated individually so
+// that their addresses remain stable.
+//
+struct named_block_table : noncopyable
+{
+    ~named_block_table()
+    {
+        for_each([&](named_block_node* node) { destroy(node); });
+    }
+
+    // Find the node with the given ID (and hash of that ID).
+    // Returns a null pointer if there is no such node.
+    named_block_node*
+    find(id_interface const& id, std::size_t hash) const
+    {
+        if (slots_.empty())
+        {
+            for (std::size_t i = 0; i != count_; ++i)
+            {
+                named_block_node* node = inline_nodes_[i];
+                if (node->id.matches(id, hash))
+                    return node;
+            }
+            return nullptr;
+        }
+        std::size_t const mask = slots_.size() - 1;
+        for (std::size_t i = home_slot(hash);; i = (i + 1) & mask)
+        {
+            named_block_node* node = slots_[i];
+            if (!node)
+                return nullptr;
+            if (node->id.matches(id, hash))
+                return node;
+        }
+    }
+
+    // Create a new node for the given ID and add it to the table.
+    // (The ID must not already be present.)
+    named_block_node*
+    create(id_interface const& id)
+    {
+        void* storage = allocator->allocate(sizeof(named_block_node));
+        named_block_node* node;
+        try
+        {
+            node = new (storage) named_block_node;
+            node->id.capture(id);
+        }
+        catch (...)
+        {
+            allocator->deallocate(storage, sizeof(named_block_node));
+            throw;
+        }
+        insert(node);
+        return node;
+    }
+
+    // Remove a node from the table and destroy it.
+    void
+    erase(named_block_node* node)
+    {
+        if (slots_.empty())
+        {
+            for (std::size_t i = 0; i != count_; ++i)
+            {
+                if (inline_nodes_[i] == node)
+                {
+                    inline_nodes_[i] = inline_nodes_[--count_];
+                    break;
+                }
+            }
+        }
+        else
+        {
+            std::size_t const mask = slots_.size() - 1;
+            std::size_t i = home_slot(node->id.hash());
+            while (slots_[i] != node)
+                i = (i + 1) & mask;
+            // Shift any subsequent nodes in the same probe sequence back so
+            // that there are no gaps in it (rather than leaving tombstones).
+            std::size_t j = i;
+            while (true)
+            {
+                j = (j + 1) & mask;
+                named_block_node* other = slots_[j];
+                if (!other)
+                    break;
+                // :other can fill the gap at :i iff its home slot doesn't lie
+                // (cyclically) within (i, j].
+                std::size_t home = home_slot(other->id.hash());
+                if (((j - home) & mask) >= ((j - i) & mask))
+                {
+                    slots_[i] = other;
+                    i = j;
+                }
+            }
+            slots_[i] = nullptr;
+            --count_;
+            // If the table has shrunk enough, switch back to inline mode.
+            if (count_ <= inline_capacity / 2)
+            {
+                std::vector<named_block_node*> slots;
+                swap(slots, slots_);
+                count_ = 0;
+                for (named_block_node* other : slots)
+                {
+                    if (other)
+                        inline_nodes_[count_++] = other;
+                }
+            }
+        }
+        destroy(node);
+    }
+
+    // Invoke :f on every node in the table (in no particular order).
+    template<class Function>
+    void
+    for_each(Function&& f)
+    {
+        if (slots_.empty())
+        {
+            for (std::size_t i = 0; i != count_; ++i)
+                f(inline_nodes_[i]);
+        }
+        else
+        {
+            for (named_block_node* node : slots_)
+            {
+                if (node)
+                    f(node);
+            }
+        }
+    }
+
+    // the allocator that supplies storage for the nodes
+    data_node_allocator* allocator = &get_heap_data_node_allocator();
+
+ private:
+    static constexpr std::size_t inline_capacity = 8;
+
+    std::size_t
+    home_slot(std::size_t hash) const
+    {
+        // Mix the hash so that IDs with poorly distributed hashes (e.g.,
+        // sequential integers that differ only in their high bits) still
+        // spread out across the table.
+        std::size_t mixed = hash * std::size_t(0x9e3779b97f4a7c15ull);
+        mixed ^= mixed >> (sizeof(std::size_t) * 4);
+        return mixed & (slots_.size() - 1);
+    }
+
+    void
+    insert(named_block_node* node)
+    {
+        if (slots_.empty())
+        {
+            if (count_ < inline_capacity)
+            {
+                inline_nodes_[count_++] = node;
+                return;
+            }
+            // Move everything out of the inline array and into a proper
+            // table.
+            rehash(inline_capacity * 4);
+        }
+        else if ((count_ + 1) * 2 > slots_.size())
+        {
+            rehash(slots_.size() * 2);
+        }
+        place(node);
+        ++count_;
+    }
+
+    // Put :node in its slot (without updating the count).
+    void
+    place(named_block_node* node)
+    {
+        std::size_t const mask = slots_.size() - 1;
+        std::size_t i = home_slot(node->id.hash());
+        while (slots_[i])
+            i = (i + 1) & mask;
+        slots_[i] = node;
+    }
+
+    void
+    rehash(std::size_t slot_count)
+    {
+        std::vector<named_block_node*> old_slots(slot_count, nullptr);
+        swap(old_slots, slots_);
+        if (old_slots.empty())
+        {
+            for (std::size_t i = 0; i != count_; ++i)
+                place(inline_nodes_[i]);
+        }
+        else
+        {
+            for (named_block_node* node : old_slots)
+            {
+                if (node)
+                    place(node);
+            }
+        }
+    }
+
+    void
+    destroy(named_block_node* node)
+    {
+        node->~named_block_node();
+        allocator->deallocate(node, sizeof(named_block_node));
+    }
+
+    // the number of nodes in the table
+    std::size_t count_ = 0;
+    // the nodes, while the table is in inline mode
+    named_block_node* inline_nodes_[inline_capacity];
+    // the hash table slots (or empty while in inline mode)
+    std::vector<named_block_node*> slots_;
+};
+
 struct naming_map
 {
-    // a map from 'names' to the associated blocks
-    typedef std::map<
-        id_interface const*,
-        named_block_node,
-        id_interface_pointer_less_than_test>
-        map_type;
-    map_type blocks;
+    // a table mapping 'names' to the associated blocks
+    named_block_table blocks;
 
     // list of named blocks referenced from this data block, in the order that
     // they appear in the traversal - Note that not all blocks necessarily
     // appear in this list. If a node requires manual deletion, it can be
-    // absent from this list but still living in the map.
+    // absent from this list but still living in the table.
     named_block_node* first = nullptr;
 };
 
@@ -104,8 +441,9 @@ void
 naming_map_node::clear_cache()
 {
     // Clear out all the caches in the individual data blocks.
-    for (auto& i : this->map.blocks)
-        clear_data_block_cache(i.second.content_block);
+    this->map.blocks.for_each([](named_block_node* node) {
+        clear_data_block_cache(node->content_block);
+    });
 }
 
 static void
@@ -113,7 +451,7 @@ release_named_block_node(naming_map& map, named_block_node* node)
 {
     if (!node->manual_delete)
     {
-        map.blocks.erase(&*node->id);
+        map.blocks.erase(node);
     }
     else
     {
@@ -136,43 +474,127 @@ release_named_block_node_list(naming_map& map, named_block_node* head)
     }
 }
 
-static void
-clear_data_node_caches(data_node* node)
+// Reverse a list of data nodes in place and return the new head.
+static data_node*
+reverse_data_node_list(data_node* head)
 {
-    // Clear node caches in reverse order to match general C++ semantics.
-    // Note that the same concerns exist here as in delete_data_nodes().
-    if (node)
+    data_node* reversed = nullptr;
+    while (head)
     {
-        clear_data_node_caches(node->alia_next_data_node_);
-        node->clear_cache();
+        data_node* next = head->alia_next_data_node_;
+        head->alia_next_data_node_ = reversed;
+        reversed = head;
+        head = next;
     }
+    return reversed;
+}
+
+// Is :node a plain data_block_node? - Since these are the nodes that are
+// responsible for nesting blocks (and can nest arbitrarily deep, e.g., in
+// loops), the functions below handle them directly rather than recursing
+// through their virtual functions. (Nodes that merely derive from
+// data_block_node might have their own ideas about what to do, so they're
+// treated like any other node.)
+static bool
+is_plain_data_block_node(data_node* node)
+{
+    return typeid(*node) == typeid(data_block_node);
 }
 
 void
 clear_data_block_cache(data_block& block)
 {
-    if (!block.cache_clear)
+    // Clear node caches in reverse order to match general C++ semantics.
+    //
+    // To do this without recursion, the node list of each block is reversed
+    // in place while it's being processed and then restored afterwards.
+    // Nested blocks are processed inline, and the only state that has to be
+    // remembered across them is where to resume in the outer block.
+    //
+    if (block.cache_clear)
+        return;
+
+    struct outer_block
+    {
+        data_block* block;
+        data_node* resume_at;
+    };
+    std::vector<outer_block> outer_blocks;
+
+    data_block* current = &block;
+    data_node* cursor = current->nodes
+        = reverse_data_node_list(current->nodes);
+    while (true)
     {
-        clear_data_node_caches(block.nodes);
-        block.cache_clear = true;
+        while (cursor)
+        {
+            data_node* node = cursor;
+            cursor = node->alia_next_data_node_;
+            if (is_plain_data_block_node(node))
+            {
+                data_block& inner = static_cast<data_block_node*>(node)->block;
+                if (!inner.cache_clear)
+                {
+                    outer_blocks.push_back(outer_block{current, cursor});
+                    current = &inner;
+                    cursor = current->nodes
+                        = reverse_data_node_list(current->nodes);
+                }
+            }
+            else
+            {
+                node->clear_cache();
+            }
+        }
+
+        current->nodes = reverse_data_node_list(current->nodes);
+        current->cache_clear = true;
+
+        if (outer_blocks.empty())
+            break;
+        current = outer_blocks.back().block;
+        cursor = outer_blocks.back().resume_at;
+        outer_blocks.pop_back();
     }
 }
 
 static void
-delete_data_nodes(data_node* node)
+delete_data_nodes(data_node* head)
 {
     // Delete nodes in reverse order to match general C++ semantics.
     //
-    // Note that this is a potential stack overflow waiting to happen.
-    // It might be worth storing a doubly linked list of nodes so that we can
-    // directly traverse them in reverse order. Of course, it's also worth
-    // considering alternate data structures that would reduce allocations and
-    // fragmentation, so I'm leaving this for the future...
+    // This is done iteratively by reversing the list in place and then
+    // consuming it from the front. When a plain data_block_node is
+    // encountered, its own nodes are spliced in ahead of it (again in
+    // reverse), so nested blocks are torn down in exactly the order that
+    // their destructors would have produced, but without recursion.
     //
-    if (node)
+    data_node* pending = reverse_data_node_list(head);
+    while (pending)
     {
-        delete_data_nodes(node->alia_next_data_node_);
-        delete node;
+        data_node* node = pending;
+        pending = node->alia_next_data_node_;
+        if (is_plain_data_block_node(node))
+        {
+            data_block& inner = static_cast<data_block_node*>(node)->block;
+            if (inner.nodes)
+            {
+                // This is what the block's destructor would do first.
+                clear_data_block_cache(inner);
+
+                // After reversal, the original head becomes the tail, and
+                // the block node itself follows that.
+                data_node* inner_tail = inner.nodes;
+                data_node* inner_head
+                    = reverse_data_node_list(inner.nodes);
+                inner.nodes = nullptr;
+                inner_tail->alia_next_data_node_ = node;
+                node->alia_next_data_node_ = pending;
+                pending = inner_head;
+                continue;
+            }
+        }
+        destroy_data_node(node);
     }
 }
 
@@ -221,11 +643,11 @@ naming_map*
 retrieve_naming_map(data_traversal& traversal)
 {
     naming_map_node* map_node;
-    if (get_data_node(
-            traversal, &map_node, [&] { return new naming_map_node; }))
+    if (get_data_node(traversal, &map_node))
     {
         data_graph& graph = *traversal.graph;
         map_node->graph = &graph;
+        map_node->map.blocks.allocator = graph.allocator;
         map_node->next = graph.map_list;
         if (graph.map_list)
             graph.map_list->prev = map_node;
@@ -352,20 +774,16 @@ find_named_block(
 
     // Otherwise, we've diverged from the predicted order, so look up
     // the node in the map.
-    naming_map::map_type::iterator i = map.blocks.find(&id);
+    std::size_t hash = id.hash();
+    named_block_node* node = map.blocks.find(id, hash);
 
     // If it's not already in the map, create it and insert it.
-    if (i == map.blocks.end())
+    if (!node)
     {
-        named_block_node new_node;
-        new_node.id.capture(id);
-        new_node.manual_delete = manual.value;
-        id_interface const* new_id = &*new_node.id;
-        i = map.blocks.emplace(new_id, std::move(new_node)).first;
+        node = map.blocks.create(id);
+        node->manual_delete = manual.value;
     }
 
-    named_block_node* node = &i->second;
-
     // If the node is currently in a list, it must be in the predicted
     // list, so remove it from there.
     remove_from_list(traversal.predicted, node);
@@ -396,16 +814,15 @@ delete_named_block(data_graph& graph, id_interface const& id)
 {
     for (naming_map_node* i = graph.map_list; i; i = i->next)
     {
-        naming_map::map_type::iterator j = i->map.blocks.find(&id);
-        if (j != i->map.blocks.end())
+        named_block_node* node = i->map.blocks.find(id, id.hash());
+        if (node)
         {
-            named_block_node* node = &j->second;
             // If the block is still active, so we don't want to delete it. We
             // just want to clear the manual_delete flag.
             if (node->next || i->map.first == node)
                 node->manual_delete = false;
             else
-                i->map.blocks.erase(&id);
+                i->map.blocks.erase(node);
         }
     }
 }
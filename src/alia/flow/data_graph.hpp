@@ -6,6 +6,8 @@
 #include <alia/signals/core.hpp>
 
 #include <cassert>
+#include <cstddef>
+#include <new>
 #include <optional>
 
 // This file defines the data retrieval library used for associating mutable
@@ -66,6 +68,79 @@ namespace alia {
 // Other nodes are irrelevant, and the library never knows about them.
 // Furthermore, not all edges need to be stored explicitly.
 
+// data_node_allocator is the interface that a data_graph uses to obtain
+// storage for its nodes. Each node remembers the allocator that supplied it,
+// so the allocator associated with a graph can be changed without disturbing
+// the nodes that already exist.
+struct data_node_allocator
+{
+    virtual ~data_node_allocator()
+    {
+    }
+
+    // Allocate storage for a node of the given size.
+    // (The storage must be suitably aligned for any fundamental type.)
+    virtual void*
+    allocate(std::size_t size)
+        = 0;
+
+    // Release storage that was obtained from allocate().
+    virtual void
+    deallocate(void* storage, std::size_t size) noexcept = 0;
+};
+
+// get_heap_data_node_allocator() returns an allocator that simply allocates
+// each node individually on the heap.
+data_node_allocator&
+get_heap_data_node_allocator();
+
+// pooled_data_node_allocator carves nodes out of larger slabs of memory.
+// Nodes are grouped into size classes, and each class keeps a free list of
+// released nodes so that they can be reused (e.g., when a named block is
+// garbage collected and another is created in its place). Nodes that are too
+// large for any of the size classes are allocated directly on the heap.
+//
+// Slabs are only returned to the heap when the allocator itself is destroyed,
+// so the allocator must outlive any nodes that it supplies.
+//
+struct pooled_data_node_allocator : data_node_allocator, noncopyable
+{
+    ~pooled_data_node_allocator();
+
+    void*
+    allocate(std::size_t size) override;
+
+    void
+    deallocate(void* storage, std::size_t size) noexcept override;
+
+    // the total number of bytes that the pool has reserved from the heap
+    std::size_t
+    reserved_bytes() const
+    {
+        return reserved_bytes_;
+    }
+
+ private:
+    static constexpr std::size_t granularity = 16;
+    static constexpr std::size_t size_class_count = 16;
+
+    struct free_block
+    {
+        free_block* next;
+    };
+
+    struct slab
+    {
+        slab* next;
+    };
+
+    free_block* free_lists_[size_class_count] = {};
+    slab* slabs_ = nullptr;
+    char* slab_cursor_ = nullptr;
+    char* slab_end_ = nullptr;
+    std::size_t reserved_bytes_ = 0;
+};
+
 // data_node represents a node in the data graph that stores data.
 struct data_node : noncopyable
 {
@@ -79,6 +154,11 @@ struct data_node : noncopyable
     }
 
     data_node* alia_next_data_node_ = nullptr;
+
+    // the allocator that supplied the storage for this node (or null if the
+    // node was created with a plain `new`) and the size of that storage
+    data_node_allocator* alia_allocator_ = nullptr;
+    std::size_t alia_allocation_size_ = 0;
 };
 
 // A data_block represents a block of execution. During a single traversal of
@@ -124,11 +204,46 @@ struct naming_map_node;
 // an actual data graph
 struct data_graph : noncopyable
 {
+    // the graph's own node pool
+    // (This is declared first so that it outlives all the graph's nodes.)
+    pooled_data_node_allocator pool;
+
+    // the allocator that's used for new nodes in the graph - By default, this
+    // is the graph's own pool, but it can be pointed elsewhere (as long as the
+    // allocator outlives the graph).
+    data_node_allocator* allocator = &pool;
+
     data_block root_block;
 
     naming_map_node* map_list = nullptr;
 };
 
+// construct_data_node<Node>(graph, args...) constructs a Node (with the given
+// constructor arguments) using storage supplied by the graph's allocator.
+template<class Node, class... Args>
+Node*
+construct_data_node(data_graph& graph, Args&&... args)
+{
+    static_assert(
+        alignof(Node) <= alignof(std::max_align_t),
+        "data nodes can't be over-aligned");
+    data_node_allocator& allocator = *graph.allocator;
+    void* storage = allocator.allocate(sizeof(Node));
+    Node* node;
+    try
+    {
+        node = new (storage) Node(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        allocator.deallocate(storage, sizeof(Node));
+        throw;
+    }
+    node->alia_allocator_ = &allocator;
+    node->alia_allocation_size_ = sizeof(Node);
+    return node;
+}
+
 struct naming_context;
 struct naming_map;
 struct named_block_node;
@@ -161,6 +276,14 @@ get_data_traversal(data_traversal& ctx)
     return ctx;
 }
 
+// A bare data traversal has no event processing associated with it, so it's
+// never aborted. (See abort_traversal.)
+inline bool
+traversal_aborted(data_traversal&)
+{
+    return false;
+}
+
 // A scoped_data_block activates the associated data_block at the beginning
 // of its scope and deactivates it at the end. It's useful anytime there is a
 // branch in the code and you need to activate the block associated with the
@@ -420,12 +543,13 @@ struct scoped_cache_clearing_disabler
 // the next node.
 //
 // In (1), you specify a custom function (:create) which allocates and
-// initializes a new object (using `new`) and returns a pointer to it.
-// get_data_node() will call this function when necessary to allocate and
-// initialize the object at this node.
+// initializes a new object and returns a pointer to it. get_data_node() will
+// call this function when necessary to allocate and initialize the object at
+// this node. The object can either be allocated with `new` or (preferably)
+// with construct_data_node().
 //
-// In (2), alia uses a default allocater/initializer that simply calls `new`
-// to create a default-constructed object.
+// In (2), alia default-constructs the object using the node allocator of the
+// graph (via construct_data_node()).
 //
 // In both forms, the return value is true if the data at the node was just
 // constructed and false if it already existed.
@@ -458,12 +582,19 @@ get_data_node(Context ctx, Node** ptr, Create&& create)
     return get_data_node(
         get_data_traversal(ctx), ptr, std::forward<Create>(create));
 }
+template<class Node>
+bool
+get_data_node(data_traversal& traversal, Node** ptr)
+{
+    return get_data_node(traversal, ptr, [&] {
+        return construct_data_node<Node>(*traversal.graph);
+    });
+}
 template<class Context, class Node>
 bool
 get_data_node(Context ctx, Node** ptr)
 {
-    return get_data_node(
-        get_data_traversal(ctx), ptr, [&] { return new Node; });
+    return get_data_node(get_data_traversal(ctx), ptr);
 }
 
 template<class T>
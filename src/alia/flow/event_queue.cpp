@@ -0,0 +1,66 @@
+#include <alia/flow/event_queue.hpp>
+
+namespace alia {
+
+namespace detail {
+
+void
+add_queued_event(
+    event_queue& queue,
+    std::unique_ptr<queued_event> event,
+    std::type_info const& type,
+    component_id target)
+{
+    ++queue.metrics.queued;
+
+    auto policy = queue.policies.find(type);
+    if (policy != queue.policies.end()
+        && policy->second == event_coalescing::keep_latest)
+    {
+        auto latest = queue.latest.try_emplace(
+            event_coalescing_key(type, target), queue.events.size());
+        if (!latest.second)
+        {
+            // Note that the latest event may have already been delivered (if
+            // this is being queued from within the batch).
+            auto& superseded = queue.events[latest.first->second];
+            if (superseded)
+            {
+                superseded.reset();
+                --queue.size;
+                ++queue.metrics.coalesced;
+            }
+            latest.first->second = queue.events.size();
+        }
+    }
+
+    queue.events.push_back(std::move(event));
+    ++queue.size;
+    if (queue.size > queue.metrics.peak_size)
+        queue.metrics.peak_size = queue.size;
+}
+
+} // namespace detail
+
+void
+deliver_queued_events(event_queue& queue, system& sys)
+{
+    // Note that delivering an event can queue more events (and thus
+    // reallocate the list), so we have to take each one out of the list
+    // before delivering it.
+    for (std::size_t i = 0; i != queue.events.size(); ++i)
+    {
+        std::unique_ptr<detail::queued_event> event
+            = std::move(queue.events[i]);
+        if (event)
+        {
+            --queue.size;
+            ++queue.metrics.delivered;
+            event->deliver(sys);
+        }
+    }
+    queue.events.clear();
+    queue.latest.clear();
+}
+
+} // namespace alia
@@ -0,0 +1,188 @@
+#ifndef ALIA_FLOW_EVENT_QUEUE_HPP
+#define ALIA_FLOW_EVENT_QUEUE_HPP
+
+#include <alia/flow/events.hpp>
+
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+// This file defines a queue for delivering events to a system in batches.
+// (See queue_event and process_event_batch in system/internals.hpp.)
+
+namespace alia {
+
+// how queued events of a particular type are coalesced
+enum class event_coalescing
+{
+    // Every queued event is delivered.
+    none,
+    // Only the most recently queued event for each target is delivered.
+    // (Untargeted events all share a single 'target'.) It's delivered in the
+    // position at which it was queued, so it still comes after any other
+    // events that were queued before it.
+    keep_latest
+};
+
+struct event_queue_metrics
+{
+    // the number of events that have been queued
+    counter_type queued = 0;
+    // the number of queued events that were dropped because a later event
+    // superseded them
+    counter_type coalesced = 0;
+    // the number of queued events that have been delivered
+    counter_type delivered = 0;
+    // the number of batches that have been processed
+    counter_type batches = 0;
+    // the largest number of events that have been waiting at once
+    std::size_t peak_size = 0;
+};
+
+namespace detail {
+
+struct queued_event
+{
+    virtual ~queued_event()
+    {
+    }
+
+    virtual void
+    deliver(system& sys)
+        = 0;
+};
+
+template<class Event>
+struct untargeted_queued_event : queued_event
+{
+    explicit untargeted_queued_event(Event event) : event(std::move(event))
+    {
+    }
+
+    void
+    deliver(system& sys) override
+    {
+        detail::dispatch_event(sys, event);
+    }
+
+    Event event;
+};
+
+template<class Event>
+struct targeted_queued_event : queued_event
+{
+    targeted_queued_event(Event event, external_component_id target)
+        : event(std::move(event)), target(std::move(target))
+    {
+    }
+
+    void
+    deliver(system& sys) override
+    {
+        detail::deliver_targeted_event(sys, event, target);
+    }
+
+    Event event;
+    external_component_id target;
+};
+
+// the key that's used to find the queued event that a new one supersedes
+typedef std::pair<std::type_index, component_id> event_coalescing_key;
+
+struct event_coalescing_key_hash
+{
+    std::size_t
+    operator()(event_coalescing_key const& key) const
+    {
+        return key.first.hash_code() * 31
+               ^ std::hash<component_id>()(key.second);
+    }
+};
+
+} // namespace detail
+
+struct event_queue
+{
+    // the queued events, in order - Events that have been delivered or
+    // superseded are left as null entries until the end of the batch.
+    std::vector<std::unique_ptr<detail::queued_event>> events;
+    // the number of non-null entries in the above
+    std::size_t size = 0;
+    // the coalescing policies for event types that have them
+    std::unordered_map<std::type_index, event_coalescing> policies;
+    // the index of the latest queued event for each coalescing key
+    std::unordered_map<
+        detail::event_coalescing_key,
+        std::size_t,
+        detail::event_coalescing_key_hash>
+        latest;
+    event_queue_metrics metrics;
+};
+
+// Set the coalescing policy for queued events of type Event.
+template<class Event>
+void
+set_event_coalescing(event_queue& queue, event_coalescing policy)
+{
+    if (policy == event_coalescing::none)
+        queue.policies.erase(typeid(Event));
+    else
+        queue.policies[typeid(Event)] = policy;
+}
+
+namespace detail {
+
+// Add :event to :queue, applying the coalescing policy for :type.
+void
+add_queued_event(
+    event_queue& queue,
+    std::unique_ptr<queued_event> event,
+    std::type_info const& type,
+    component_id target);
+
+} // namespace detail
+
+// Queue an untargeted event for delivery in the next batch.
+template<class Event>
+void
+queue_event(event_queue& queue, Event event)
+{
+    detail::add_queued_event(
+        queue,
+        std::make_unique<detail::untargeted_queued_event<Event>>(
+            std::move(event)),
+        typeid(Event),
+        nullptr);
+}
+
+// Queue an event for delivery to :target in the next batch.
+template<class Event>
+void
+queue_targeted_event(
+    event_queue& queue, Event event, external_component_id target)
+{
+    component_id id = target.id;
+    detail::add_queued_event(
+        queue,
+        std::make_unique<detail::targeted_queued_event<Event>>(
+            std::move(event), std::move(target)),
+        typeid(Event),
+        id);
+}
+
+// Are there any events waiting in :queue?
+inline bool
+has_queued_events(event_queue const& queue)
+{
+    return queue.size != 0;
+}
+
+// Deliver all events that are waiting in :queue to :sys, in order, without
+// refreshing it. Events that are queued during this are also delivered.
+void
+deliver_queued_events(event_queue& queue, system& sys);
+
+} // namespace alia
+
+#endif
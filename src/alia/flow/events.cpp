@@ -3,6 +3,8 @@
 #include <alia/system/internals.hpp>
 #include <alia/timing/ticks.hpp>
 
+#include <algorithm>
+
 namespace alia {
 
 static void
@@ -23,6 +25,19 @@ invoke_controller(system& sys, event_traversal& events)
 
     scoped_component_container root(ctx, &sys.root_component);
 
+    if (events.is_refresh)
+    {
+        sys.root_component->reentry_needed = false;
+        // A full refresh visits all active isolated components, so none of
+        // them need to be re-entered. (And any inactive ones shouldn't be.)
+        for (component_reentry_point* p : sys.pending_reentries)
+        {
+            if (p)
+                p->container->reentry_needed = false;
+        }
+        sys.pending_reentries.clear();
+    }
+
     sys.controller(ctx);
 }
 
@@ -63,14 +78,117 @@ route_event(
     }
 }
 
+// Does :point have an enclosing isolated component that also needs to be
+// refreshed?
+static bool
+has_pending_reentry_ancestor(component_reentry_point const& point)
+{
+    for (component_container* c = point.container->parent.get(); c;
+         c = c->parent.get())
+    {
+        if (c->reentry && c->reentry_needed)
+            return true;
+    }
+    return false;
+}
+
+static void
+reenter_component(system& sys, component_reentry_point& point)
+{
+    refresh_event refresh;
+    event_traversal events;
+    events.targeted = false;
+    events.is_refresh = true;
+    events.event_type = &typeid(refresh_event);
+    events.event = &refresh;
+    // The component's container is already linked to its parent, so make
+    // that the active container to keep it that way.
+    events.active_container = &point.container->parent;
+
+    // The component activates its own data block, so this doesn't need to
+    // activate the root block.
+    data_traversal data;
+    data.graph = &sys.data;
+    data.gc_enabled = data.cache_clearing_enabled = true;
+
+    timing_subsystem timing;
+    timing.tick_counter = sys.external->get_tick_count();
+
+    context_storage storage;
+    context ctx = make_context(&storage, sys, events, data, timing);
+
+    point.reenter(ctx);
+}
+
+void
+refresh_isolated_components(system& sys)
+{
+    auto& pending = sys.pending_reentries;
+    auto const end = pending.begin() + pending.size();
+
+    // Move the outermost components that still need to be refreshed to the
+    // front. (Nested ones will be refreshed along with their parents, so
+    // they're left in the list in case that doesn't happen.) Stale entries
+    // go to the back.
+    auto needed_end = std::partition(
+        pending.begin(), end, [](component_reentry_point* p) {
+            return p && p->container->reentry_needed;
+        });
+    auto outer_end = std::partition(
+        pending.begin(), needed_end, [](component_reentry_point* p) {
+            return !has_pending_reentry_ancestor(*p);
+        });
+
+    // The containers above the outermost components are only dirty because
+    // of changes within those components, which we're about to take care of.
+    for (auto i = pending.begin(); i != outer_end; ++i)
+    {
+        for (component_container* c = (*i)->container->parent.get(); c;
+             c = c->parent.get())
+        {
+            c->dirty = false;
+            c->animating = false;
+        }
+    }
+
+    std::size_t const outer_count = outer_end - pending.begin();
+    std::size_t const original_count = end - pending.begin();
+    // Note that entries can be nulled out (or added) while we do this.
+    for (std::size_t i = 0; i != outer_count; ++i)
+    {
+        component_reentry_point* point = pending[i];
+        if (point && point->container->reentry_needed)
+            reenter_component(sys, *point);
+    }
+
+    // Remove the entries that we took care of (including nested ones that
+    // were refreshed along with their parents). Entries that were added
+    // during the refresh are left for the next pass.
+    auto const original_end = pending.begin() + original_count;
+    pending.erase(
+        std::remove_if(
+            pending.begin(),
+            original_end,
+            [](component_reentry_point* p) {
+                return !p || !p->container->reentry_needed;
+            }),
+        original_end);
+}
+
 } // namespace detail
 
 void
 abort_traversal(dataless_context ctx)
 {
     assert(!is_refresh_event(ctx));
-    get_event_traversal(ctx).aborted = true;
-    throw traversal_abortion();
+    event_traversal& traversal = get_event_traversal(ctx);
+    traversal.aborted = true;
+    // Any deferred parallel_apply work would just be thrown away, so drop it
+    // now rather than letting it hold on to its captures until the scopes
+    // end.
+    detail::discard_parallel_apply_work(traversal);
+    if (!get<system_tag>(ctx).exception_free_abortion)
+        throw traversal_abortion();
 }
 
 void
@@ -95,6 +213,72 @@ get_component_id(context ctx)
     return id;
 }
 
+namespace detail {
+
+static void
+unregister_direct_event_handler(direct_event_handler_node& node)
+{
+    auto& handlers = node.sys->direct_event_handlers;
+    auto range = handlers.equal_range(node.id);
+    for (auto i = range.first; i != range.second; ++i)
+    {
+        if (i->second == &node)
+        {
+            handlers.erase(i);
+            break;
+        }
+    }
+    node.sys = nullptr;
+}
+
+direct_event_handler_node::~direct_event_handler_node()
+{
+    if (sys)
+        unregister_direct_event_handler(*this);
+}
+
+void
+register_direct_event_handler(
+    system& sys,
+    direct_event_handler_node& node,
+    component_id id,
+    std::type_info const& type)
+{
+    if (node.sys == &sys && node.id == id && node.event_type == &type)
+        return;
+    if (node.sys)
+        unregister_direct_event_handler(node);
+    node.sys = &sys;
+    node.id = id;
+    node.event_type = &type;
+    sys.direct_event_handlers.emplace(id, &node);
+}
+
+bool
+deliver_direct_targeted_event(
+    system& sys,
+    void* event,
+    std::type_info const& type,
+    external_component_id const& component)
+{
+    // As with routed events, events for components that no longer exist are
+    // dropped (by the routing logic).
+    if (component.identity.expired())
+        return false;
+    auto range = sys.direct_event_handlers.equal_range(component.id);
+    for (auto i = range.first; i != range.second; ++i)
+    {
+        if (*i->second->event_type == type)
+        {
+            i->second->handle(event);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace detail
+
 struct initialization_detection
 {
     bool initialized = false;
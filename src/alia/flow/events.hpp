@@ -7,6 +7,9 @@
 #include <alia/flow/macros.hpp>
 #include <alia/system/interface.hpp>
 
+#include <optional>
+#include <typeinfo>
+
 // This file implements utilities for routing events through an alia content
 // traversal function.
 //
@@ -29,6 +32,8 @@ namespace alia {
 
 struct system;
 
+struct parallel_apply_scope;
+
 struct event_routing_path
 {
     component_container* node;
@@ -44,8 +49,19 @@ struct event_traversal
     std::type_info const* event_type;
     void* event;
     bool aborted = false;
+    // the innermost active parallel_apply_scope (if any)
+    parallel_apply_scope* parallel_scope = nullptr;
 };
 
+namespace detail {
+
+// Drop the parallel_apply computations that are waiting in the active
+// scopes of :traversal. (This is defined in signals/parallel_apply.cpp.)
+void
+discard_parallel_apply_work(event_traversal& traversal);
+
+} // namespace detail
+
 template<class Context>
 component_container_ptr const&
 get_active_component_container(Context ctx)
@@ -67,6 +83,11 @@ void
 route_event(
     system& sys, event_traversal& traversal, component_container* target);
 
+// Refresh the isolated components of :sys that have changed, without running
+// the rest of the controller. (See invoke_isolated_component.)
+void
+refresh_isolated_components(system& sys);
+
 template<class Event>
 void
 dispatch_targeted_event(
@@ -111,6 +132,12 @@ struct traversal_abortion
 {
 };
 
+// abort_traversal(ctx) ends the processing of the current (non-refresh) event
+// traversal. By default, this throws a traversal_abortion exception, which is
+// caught by the code that dispatched the event. If the system is configured
+// for exception-free abortion, this instead just flags the traversal as
+// aborted, and the control flow constructs (ALIA_IF, ALIA_FOR, for_each,
+// component containers, etc.) skip everything that's left in the traversal.
 void
 abort_traversal(dataless_context ctx);
 
@@ -125,7 +152,7 @@ bool
 detect_event(dataless_context ctx, Event** event)
 {
     event_traversal& traversal = get_event_traversal(ctx);
-    if (*traversal.event_type == typeid(Event))
+    if (*traversal.event_type == typeid(Event) && !traversal.aborted)
     {
         *event = reinterpret_cast<Event*>(traversal.event);
         return true;
@@ -182,16 +209,40 @@ externalize(component_id id)
 
 struct targeted_event
 {
-    component_id target_id;
+    component_id target_id = nullptr;
 };
 
+namespace detail {
+
+// If :component has a direct handler for events of type :type, deliver
+// :event to it directly and return true. (See direct_targeted_event_handler.)
+bool
+deliver_direct_targeted_event(
+    system& sys,
+    void* event,
+    std::type_info const& type,
+    external_component_id const& component);
+
+// Deliver :event to :component (directly, if possible), without refreshing
+// the system afterwards.
+template<class Event>
+void
+deliver_targeted_event(
+    system& sys, Event& event, external_component_id const& component)
+{
+    event.target_id = component.id;
+    if (!deliver_direct_targeted_event(sys, &event, typeid(Event), component))
+        dispatch_targeted_event(sys, event, component.identity);
+}
+
+} // namespace detail
+
 template<class Event>
 void
 dispatch_targeted_event(
     system& sys, Event& event, external_component_id component)
 {
-    event.target_id = component.id;
-    detail::dispatch_targeted_event(sys, event, component.identity);
+    detail::deliver_targeted_event(sys, event, component);
     refresh_system(sys);
 }
 
@@ -215,6 +266,87 @@ targeted_event_handler(Context ctx, component_id id, Handler&& handler)
     ALIA_END
 }
 
+// direct targeted event handlers...
+
+namespace detail {
+
+struct direct_event_handler_node
+{
+    virtual ~direct_event_handler_node();
+
+    virtual void
+    handle(void* event)
+        = 0;
+
+    // the system that this handler is registered with (if any)
+    system* sys = nullptr;
+    // the component and event type that it's registered for
+    component_id id = nullptr;
+    std::type_info const* event_type = nullptr;
+};
+
+// Register :node as the direct handler for events of type :type that are
+// targeted at :id. (If it's already registered, this just updates it.)
+void
+register_direct_event_handler(
+    system& sys,
+    direct_event_handler_node& node,
+    component_id id,
+    std::type_info const& type);
+
+template<class Event, class Handler>
+struct typed_direct_event_handler : direct_event_handler_node
+{
+    // a copy of the handler from the last refresh
+    std::optional<Handler> handler;
+
+    void
+    handle(void* event) override
+    {
+        (*handler)(*static_cast<Event*>(event));
+    }
+};
+
+} // namespace detail
+
+// direct_targeted_event_handler<Event>(ctx, id, handler) is like
+// targeted_event_handler, but :handler is invoked as handler(event), without
+// a context, and when an Event is dispatched to :id, it's delivered directly
+// to :handler, without a traversal of the component tree.
+//
+// This is suitable for handlers that only need to update persistent state
+// (e.g., by writing to state signals). Since :handler is stored and invoked
+// outside of the traversal, it must capture everything it uses by value (or
+// by reference to something that outlives the component). A fresh copy is
+// stored on every refresh.
+//
+// Events that are delivered through a traversal (e.g., because they were
+// dispatched before the handler was registered) are still handled.
+//
+template<class Event, class Context, class Handler>
+void
+direct_targeted_event_handler(
+    Context ctx, component_id id, Handler&& handler)
+{
+    detail::typed_direct_event_handler<Event, std::decay_t<Handler>>* node;
+    get_cached_data(ctx, &node);
+    ALIA_UNTRACKED_IF(get_event_traversal(ctx).is_refresh)
+    {
+        node->handler.reset();
+        node->handler.emplace(handler);
+        detail::register_direct_event_handler(
+            get<system_tag>(ctx), *node, id, typeid(Event));
+    }
+    ALIA_END
+    Event* e;
+    ALIA_UNTRACKED_IF(detect_targeted_event(ctx, id, &e))
+    {
+        handler(*e);
+        abort_traversal(ctx);
+    }
+    ALIA_END
+}
+
 // the refresh event...
 
 struct refresh_event
@@ -110,6 +110,8 @@ for_each(Context ctx, ContainerSignal const& container_signal, Fn&& fn)
         auto const& container = read_signal(container_signal);
         for (auto const& item : container)
         {
+            if (traversal_aborted(ctx))
+                break;
             auto key = direct(item.first);
             auto value = container_signal[key];
             invoke_map_iteration_body(
@@ -219,6 +221,8 @@ for_each(Context ctx, ContainerSignal const& container_signal, Fn&& fn)
         size_t const item_count = container.size();
         for (size_t index = 0; index != item_count; ++index)
         {
+            if (traversal_aborted(ctx))
+                break;
             invoke_sequence_iteration_body(
                 fn,
                 nc,
@@ -258,6 +262,8 @@ for_each(Context ctx, Container&& container, Fn&& fn)
     size_t index = 0;
     for (auto&& item : container)
     {
+        if (traversal_aborted(ctx))
+            break;
         invoke_sequence_iteration_body(
             fn,
             nc,
@@ -296,6 +302,8 @@ for_each(Context ctx, Container&& container, Fn&& fn)
     size_t index = 0;
     for (auto&& item : container)
     {
+        if (traversal_aborted(ctx))
+            break;
         invoke_sequence_iteration_body(
             fn,
             nc,
@@ -395,6 +403,8 @@ for_each(Context ctx, ContainerSignal const& container_signal, Fn&& fn)
         size_t index = 0;
         for (auto const& item : container)
         {
+            if (traversal_aborted(ctx))
+                break;
             invoke_sequence_iteration_body(
                 fn,
                 nc,
@@ -435,6 +445,8 @@ for_each(Context ctx, Container&& container, Fn&& fn)
     size_t index = 0;
     for (auto&& item : container)
     {
+        if (traversal_aborted(ctx))
+            break;
         invoke_sequence_iteration_body(
             fn,
             nc,
@@ -473,6 +485,8 @@ for_each(Context ctx, Container&& container, Fn&& fn)
     size_t index = 0;
     for (auto&& item : container)
     {
+        if (traversal_aborted(ctx))
+            break;
         invoke_sequence_iteration_body(
             fn,
             nc,
@@ -0,0 +1,90 @@
+#ifndef ALIA_FLOW_ISOLATION_HPP
+#define ALIA_FLOW_ISOLATION_HPP
+
+#include <optional>
+
+#include <alia/context/interface.hpp>
+#include <alia/flow/components.hpp>
+#include <alia/flow/data_graph.hpp>
+#include <alia/flow/events.hpp>
+#include <alia/system/internals.hpp>
+
+namespace alia {
+
+namespace detail {
+
+template<class Content>
+struct isolated_component_data : component_reentry_point
+{
+    data_block block;
+    // a copy of the content function from the last refresh
+    std::optional<Content> content;
+
+    void
+    reenter(context ctx) override
+    {
+        scoped_component_container scoped_container(ctx, &this->container);
+        this->container->reentry_needed = false;
+        scoped_data_block scoped_block(ctx, block);
+        (*content)(ctx);
+    }
+};
+
+} // namespace detail
+
+// invoke_isolated_component(ctx, content) invokes :content as an isolated
+// component. :content is invoked as content(isolated_ctx), where
+// :isolated_ctx is a fresh root context. (In particular, it doesn't carry any
+// objects that have been added to :ctx.)
+//
+// Since its content doesn't depend on anything in the surrounding context,
+// an isolated component can be refreshed on its own, without running the rest
+// of the controller. When incremental refreshes are enabled (see
+// system::incremental_refresh), changes within isolated components are
+// handled by re-entering just the components that contain them.
+//
+// Note that :content is stored and invoked again later, so it must capture
+// everything it uses by value (or by reference to something that outlives the
+// system). A fresh copy is stored on every full refresh.
+//
+template<class Content>
+void
+invoke_isolated_component(context ctx, Content&& content)
+{
+    detail::isolated_component_data<std::decay_t<Content>>* data;
+    if (get_data(ctx, &data))
+    {
+        data->sys = &get<system_tag>(ctx);
+        data->container.reset(new component_container);
+        data->container->reentry = data;
+    }
+
+    scoped_component_container container(ctx, &data->container);
+
+    if (is_refresh_event(ctx))
+    {
+        data->content.reset();
+        data->content.emplace(content);
+        data->container->reentry_needed = false;
+    }
+    else if (!container.is_on_route())
+    {
+        return;
+    }
+
+    // Invoke the content within the same kind of context that the re-entry
+    // point will see.
+    context_storage storage;
+    context isolated_ctx = make_context(
+        &storage,
+        get<system_tag>(ctx),
+        get_event_traversal(ctx),
+        get_data_traversal(ctx),
+        get<timing_tag>(ctx));
+    scoped_data_block block(isolated_ctx, data->block);
+    content(isolated_ctx);
+}
+
+} // namespace alia
+
+#endif
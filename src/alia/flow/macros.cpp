@@ -5,7 +5,7 @@ namespace alia {
 if_block::if_block(data_traversal& traversal, bool condition)
 {
     data_block_node* node;
-    get_data_node(traversal, &node, [&] { return new data_block_node; });
+    get_data_node(traversal, &node);
     if (condition)
     {
         scoped_data_block_.begin(traversal, node->block);
@@ -27,14 +27,14 @@ loop_block::~loop_block()
     // iteration (and, indirectly, all subsequent iterations), but since the
     // destructor is being invoked, there won't be a next iteration, which
     // means we should clear out that block.
-    if (!exception_detector_.detect())
+    if (block_ && !exception_detector_.detect())
         clear_data_block(*block_);
 }
 void
 loop_block::next()
 {
     data_block_node* node;
-    get_data_node(*traversal_, &node, [&] { return new data_block_node; });
+    get_data_node(*traversal_, &node);
     block_ = &node->block;
 }
 
@@ -42,7 +42,7 @@ event_dependent_if_block::event_dependent_if_block(
     data_traversal& traversal, bool condition)
 {
     data_block_node* node;
-    get_data_node(traversal, &node, [&] { return new data_block_node; });
+    get_data_node(traversal, &node);
     if (condition)
     {
         scoped_data_block_.begin(traversal, node->block);
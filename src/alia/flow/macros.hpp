@@ -52,6 +52,13 @@ struct loop_block : noncopyable
     }
     void
     next();
+    // Leave the loop without clearing out the data for the remaining
+    // iterations. (This is done when the traversal is aborted.)
+    void
+    abandon()
+    {
+        block_ = nullptr;
+    }
 
  private:
     data_traversal* traversal_;
@@ -70,6 +77,9 @@ struct event_dependent_if_block : noncopyable
 // The following are macros used to annotate control flow.
 // They are used exactly like their C equivalents, but all require an alia_end
 // after the end of their scope.
+// Note that the tracked forms skip their contents once the traversal has been
+// aborted (see abort_traversal), so they require that the context (or data
+// traversal) supports traversal_aborted(ctx).
 // Also note that all come in two forms. One form ends in an underscore and
 // takes the context as its first argument. The other form has no trailing
 // underscore and assumes that the context is a variable named 'ctx'.
@@ -168,6 +178,8 @@ read_condition(T const& x)
                 = ::alia::condition_is_true(_alia_condition);                 \
             _alia_else_condition                                              \
                 = ::alia::condition_is_false(_alia_condition);                \
+            if (traversal_aborted(ctx))                                       \
+                _alia_if_condition = _alia_else_condition = false;            \
             ::alia::if_block _alia_if_block(                                  \
                 get_data_traversal(ctx), _alia_if_condition);                 \
             if (_alia_if_condition)                                           \
@@ -183,7 +195,7 @@ read_condition(T const& x)
     {                                                                         \
         auto const& _alia_condition = (condition);                            \
         bool _alia_else_if_condition                                          \
-            = _alia_else_condition                                            \
+            = _alia_else_condition && !traversal_aborted(ctx)                 \
               && ::alia::condition_is_true(_alia_condition);                  \
         _alia_else_condition                                                  \
             = _alia_else_condition                                            \
@@ -201,6 +213,8 @@ read_condition(T const& x)
     }                                                                         \
     }                                                                         \
     {                                                                         \
+        if (traversal_aborted(ctx))                                           \
+            _alia_else_condition = false;                                     \
         ::alia::if_block _alia_if_block(                                      \
             get_data_traversal(ctx), _alia_else_condition);                   \
         if (_alia_else_condition)                                             \
@@ -225,7 +239,8 @@ read_condition(T const& x)
     {                                                                         \
         ::alia::switch_block _alia_switch_block(ctx);                         \
         auto const& _alia_switch_value = (x);                                 \
-        if (::alia::condition_has_value(_alia_switch_value))                  \
+        if (::alia::condition_has_value(_alia_switch_value)                   \
+            && !traversal_aborted(ctx))                                       \
         {                                                                     \
             switch (::alia::read_condition(_alia_switch_value))               \
             {                                                                 \
@@ -270,6 +285,11 @@ read_condition(T const& x)
             ::alia::loop_block _alia_looper(get_data_traversal(ctx));         \
             for (x)                                                           \
             {                                                                 \
+                if (traversal_aborted(ctx))                                   \
+                {                                                             \
+                    _alia_looper.abandon();                                   \
+                    break;                                                    \
+                }                                                             \
                 ::alia::scoped_data_block _alia_scope;                        \
                 _alia_scope.begin(                                            \
                     _alia_looper.traversal(), _alia_looper.block());          \
@@ -292,6 +312,11 @@ read_condition(T const& x)
             ::alia::loop_block _alia_looper(get_data_traversal(ctx));         \
             while (x)                                                         \
             {                                                                 \
+                if (traversal_aborted(ctx))                                   \
+                {                                                             \
+                    _alia_looper.abandon();                                   \
+                    break;                                                    \
+                }                                                             \
                 ::alia::scoped_data_block _alia_scope;                        \
                 _alia_scope.begin(                                            \
                     _alia_looper.traversal(), _alia_looper.block());          \
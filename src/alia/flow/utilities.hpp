@@ -25,8 +25,10 @@ T&
 make_returnable_ref(context ctx, T x)
 {
     returnable_ref_node<T>* node;
-    if (!get_data_node(
-            ctx, &node, [&] { return new returnable_ref_node<T>(x); }))
+    if (!get_data_node(ctx, &node, [&] {
+            return construct_data_node<returnable_ref_node<T>>(
+                *get_data_traversal(ctx).graph, x);
+        }))
     {
         node->value = std::move(x);
     }
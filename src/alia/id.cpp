@@ -1,19 +1,19 @@
 #include <alia/id.hpp>
-#include <typeinfo>
 
 namespace alia {
 
 inline bool
 types_match(id_interface const& a, id_interface const& b)
 {
-    return typeid(a).name() == typeid(b).name() || typeid(a) == typeid(b);
+    return a.type_token() == b.type_token();
 }
 
 bool
 operator<(id_interface const& a, id_interface const& b)
 {
-    return typeid(a).before(typeid(b))
-           || (types_match(a, b) && a.less_than(b));
+    id_type_token a_token = a.type_token(), b_token = b.type_token();
+    return std::less<id_type_token>()(a_token, b_token)
+           || (a_token == b_token && a.less_than(b));
 }
 
 void
@@ -52,11 +52,108 @@ clone_into(std::unique_ptr<id_interface>& storage, id_interface const* id)
     }
 }
 
+void
+captured_id::clear() noexcept
+{
+    if (id_)
+    {
+        if (is_inline_)
+            id_->~id_interface();
+        else
+            delete id_;
+        id_ = nullptr;
+        is_inline_ = false;
+    }
+    hash_ = 0;
+}
+
+void
+captured_id::capture(id_interface const& new_id)
+{
+    if (&new_id == id_)
+        return;
+    this->capture(new_id, new_id.hash());
+}
+
+void
+captured_id::capture(id_interface const& new_id, std::size_t hash)
+{
+    if (&new_id == id_)
+        return;
+    // Inline IDs are always recaptured via clone_in_place() since that's
+    // just as cheap, and a deep_copy() into inline storage might try to
+    // allocate (e.g., for a simple_id_by_reference).
+    if (id_ && !is_inline_ && types_match(*id_, new_id))
+    {
+        new_id.deep_copy(id_);
+    }
+    else
+    {
+        // The new ID is cloned before the old one is destroyed so that if
+        // cloning throws, we still have the old one.
+        if (id_ && is_inline_)
+        {
+            // The old ID is occupying our inline storage, so try cloning the
+            // new one into a temporary buffer and then relocate it. (Inline
+            // IDs can always be relocated by cloning them again.)
+            alignas(std::max_align_t) unsigned char
+                buffer[inline_storage_size];
+            id_interface* copy
+                = new_id.clone_in_place(buffer, inline_storage_size);
+            if (copy)
+            {
+                id_->~id_interface();
+                id_ = copy->clone_in_place(storage_, inline_storage_size);
+                copy->~id_interface();
+            }
+            else
+            {
+                copy = new_id.clone();
+                id_->~id_interface();
+                id_ = copy;
+                is_inline_ = false;
+            }
+        }
+        else
+        {
+            id_interface* copy
+                = new_id.clone_in_place(storage_, inline_storage_size);
+            bool const copy_is_inline = copy != nullptr;
+            if (!copy)
+                copy = new_id.clone();
+            delete id_;
+            id_ = copy;
+            is_inline_ = copy_is_inline;
+        }
+    }
+    hash_ = hash;
+}
+
+void
+captured_id::take(captured_id& other) noexcept
+{
+    if (other.is_inline_)
+    {
+        // Inline IDs are relocated by cloning them into our own storage.
+        id_ = other.id_->clone_in_place(storage_, inline_storage_size);
+        is_inline_ = true;
+        hash_ = other.hash_;
+        other.clear();
+    }
+    else
+    {
+        id_ = other.id_;
+        hash_ = other.hash_;
+        other.id_ = nullptr;
+        other.hash_ = 0;
+    }
+}
+
 bool
 operator==(captured_id const& a, captured_id const& b)
 {
     return a.is_initialized() == b.is_initialized()
-           && (!a.is_initialized() || *a == *b);
+           && (!a.is_initialized() || (a.hash() == b.hash() && *a == *b));
 }
 bool
 operator!=(captured_id const& a, captured_id const& b)
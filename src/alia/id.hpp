@@ -2,14 +2,41 @@
 #define ALIA_ID_HPP
 
 #include <alia/common.hpp>
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <new>
 #include <sstream>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
 
 // This file implements the concept of IDs in alia.
 
 namespace alia {
 
+// An id_type_token is a cheap, unique stand-in for the dynamic type of an ID.
+// Tokens can be compared for equality and (arbitrarily but consistently)
+// ordered. They're NOT stable across runs of the program.
+typedef void const* id_type_token;
+
+namespace detail {
+
+template<class Id>
+inline char const id_type_token_anchor = 0;
+
+} // namespace detail
+
+// get_id_type_token<Id>() returns a token for the type Id.
+// (The token is the address of a static variable that's unique to Id.)
+template<class Id>
+id_type_token
+get_id_type_token()
+{
+    return &detail::id_type_token_anchor<Id>;
+}
+
 // id_interface defines the interface required of all ID types.
 struct id_interface
 {
@@ -17,6 +44,17 @@ struct id_interface
     {
     }
 
+    // Get the token for the dynamic type of this ID. IDs are only considered
+    // equal if their tokens match, and IDs with different tokens are ordered
+    // by their tokens. The default implementation uses the address of the
+    // std::type_info for the type, but ID types should override this to
+    // return get_id_type_token<Self>(), which is cheaper.
+    virtual id_type_token
+    type_token() const
+    {
+        return &typeid(*this);
+    }
+
     // Create a standalone copy of the ID.
     virtual id_interface*
     clone() const = 0;
@@ -35,18 +73,57 @@ struct id_interface
     // one.
     virtual bool
     less_than(id_interface const& other) const = 0;
+
+    // Return a hash of the ID's value.
+    // IDs that are equal must produce equal hashes, and an ID's hash must not
+    // change as long as its value doesn't. (Hashes are NOT guaranteed to be
+    // consistent across runs of the program, so they shouldn't be persisted.)
+    // The default implementation simply returns a constant, which is correct
+    // but means that hashed lookups of the ID degenerate into linear
+    // searches, so ID types are strongly encouraged to override this.
+    virtual std::size_t
+    hash() const
+    {
+        return 0;
+    }
+
+    // Is the hash of this ID meaningful? - This is false if the ID (or any
+    // part of it) falls back to a constant hash (as above), in which case
+    // unequal IDs will routinely share the same hash. Code that's willing to
+    // treat matching hashes as matching IDs must check this first.
+    virtual bool
+    hash_is_meaningful() const
+    {
+        return false;
+    }
+
+    // Construct a standalone copy of the ID within :storage (which is :size
+    // bytes and suitably aligned for any fundamental type) and return a
+    // pointer to it. This should only be done if the copy fits and owns no
+    // external resources, so that it can be freely relocated (by cloning it
+    // again) and destroyed in place. Otherwise (and by default), this returns
+    // a null pointer, and the ID is cloned onto the heap instead.
+    virtual id_interface*
+    clone_in_place(void*, std::size_t) const
+    {
+        return nullptr;
+    }
 };
 
+// combine_id_hashes(a, b) combines two ID hashes into one.
+inline std::size_t
+combine_id_hashes(std::size_t a, std::size_t b)
+{
+    return a ^ (b + std::size_t(0x9e3779b97f4a7c15ull) + (a << 6) + (a >> 2));
+}
+
 // The following convert the interface of the ID operations into the usual form
 // that one would expect, as free functions.
 
 inline bool
 operator==(id_interface const& a, id_interface const& b)
 {
-    // Apparently it's faster to compare the name pointers for equality before
-    // resorting to actually comparing the typeid objects themselves.
-    return (typeid(a).name() == typeid(b).name() || typeid(a) == typeid(b))
-           && a.equals(b);
+    return a.type_token() == b.type_token() && a.equals(b);
 }
 
 inline bool
@@ -84,8 +161,16 @@ clone_into(std::unique_ptr<id_interface>& storage, id_interface const* id);
 
 // captured_id is used to capture an ID for long-term storage (beyond the point
 // where the id_interface reference will be valid).
+//
+// Small IDs that support clone_in_place() (e.g., simple_ids of trivially
+// copyable values and pairs of them) are stored inline, so capturing them
+// doesn't require any heap allocation.
+//
 struct captured_id
 {
+    // the size of the inline storage for IDs
+    static constexpr std::size_t inline_storage_size = 48;
+
     captured_id()
     {
     }
@@ -100,11 +185,18 @@ struct captured_id
     }
     captured_id(captured_id&& other) noexcept
     {
-        id_ = std::move(other.id_);
+        this->take(other);
+    }
+    ~captured_id()
+    {
+        if (id_)
+            this->clear();
     }
     captured_id&
     operator=(captured_id const& other)
     {
+        if (this == &other)
+            return *this;
         if (other.is_initialized())
             this->capture(*other);
         else
@@ -114,42 +206,74 @@ struct captured_id
     captured_id&
     operator=(captured_id&& other) noexcept
     {
-        id_ = std::move(other.id_);
+        if (this != &other)
+        {
+            this->clear();
+            this->take(other);
+        }
         return *this;
     }
     void
-    clear()
-    {
-        id_.reset();
-    }
+    clear() noexcept;
     void
-    capture(id_interface const& new_id)
-    {
-        clone_into(id_, &new_id);
-    }
+    capture(id_interface const& new_id);
+    // This is equivalent to capture(new_id), but when the hash of :new_id is
+    // already known, it avoids recomputing it.
+    void
+    capture(id_interface const& new_id, std::size_t hash);
     bool
     is_initialized() const
     {
         return id_ ? true : false;
     }
+    // Is the ID stored inline (rather than on the heap)?
+    bool
+    is_inline() const
+    {
+        return is_inline_;
+    }
     id_interface const&
     operator*() const
     {
         return *id_;
     }
+    // the hash of the captured ID (or 0 if there's no ID)
+    std::size_t
+    hash() const
+    {
+        return hash_;
+    }
     bool
     matches(id_interface const& id) const
     {
         return id_ && *id_ == id;
     }
+    // This is equivalent to matches(id), but when the hash of :id is already
+    // known, it allows mismatches to be rejected without any virtual calls.
+    bool
+    matches(id_interface const& id, std::size_t hash) const
+    {
+        return id_ && hash_ == hash && *id_ == id;
+    }
     friend void
     swap(captured_id& a, captured_id& b) noexcept
     {
-        swap(a.id_, b.id_);
+        captured_id tmp(std::move(a));
+        a = std::move(b);
+        b = std::move(tmp);
     }
 
  private:
-    std::unique_ptr<id_interface> id_;
+    // Take over the ID stored in :other (leaving :other empty).
+    void
+    take(captured_id& other) noexcept;
+
+    alignas(std::max_align_t) unsigned char storage_[inline_storage_size];
+    id_interface* id_ = nullptr;
+    // The hash of the captured ID is cached here since it's often needed
+    // repeatedly.
+    std::size_t hash_ = 0;
+    bool is_inline_ = false;
 };
 bool
 operator==(captured_id const& a, captured_id const& b);
@@ -159,14 +283,51 @@ bool
 operator<(captured_id const& a, captured_id const& b);
 
 // ref(id) wraps a reference to an id_interface so that it can be combined.
+//
+// When an id_ref is cloned or deep-copied, the copy captures its own copy of
+// the referenced ID (inline, if possible), so recapturing an id_ref into a
+// copy that already exists doesn't normally require any allocation.
+//
 struct id_ref : id_interface
 {
-    id_ref() : id_(0), ownership_()
+    id_ref() : id_(nullptr)
+    {
+    }
+
+    id_ref(id_interface const& id) : id_(&id)
+    {
+    }
+
+    id_ref(id_ref const& other) : ownership_(other.ownership_)
+    {
+        id_ = ownership_.is_initialized() ? &*ownership_ : other.id_;
+    }
+
+    id_ref(id_ref&& other) noexcept : ownership_(std::move(other.ownership_))
     {
+        id_ = ownership_.is_initialized() ? &*ownership_ : other.id_;
     }
 
-    id_ref(id_interface const& id) : id_(&id), ownership_()
+    id_ref&
+    operator=(id_ref const& other)
     {
+        ownership_ = other.ownership_;
+        id_ = ownership_.is_initialized() ? &*ownership_ : other.id_;
+        return *this;
+    }
+
+    id_ref&
+    operator=(id_ref&& other) noexcept
+    {
+        ownership_ = std::move(other.ownership_);
+        id_ = ownership_.is_initialized() ? &*ownership_ : other.id_;
+        return *this;
+    }
+
+    id_type_token
+    type_token() const override
+    {
+        return get_id_type_token<id_ref>();
     }
 
     id_interface*
@@ -191,25 +352,29 @@ struct id_ref : id_interface
         return *id_ < *other_id.id_;
     }
 
+    std::size_t
+    hash() const override
+    {
+        return id_->hash();
+    }
+
+    bool
+    hash_is_meaningful() const override
+    {
+        return id_->hash_is_meaningful();
+    }
+
     void
     deep_copy(id_interface* copy) const override
     {
         auto& typed_copy = *static_cast<id_ref*>(copy);
-        if (ownership_)
-        {
-            typed_copy.ownership_ = ownership_;
-            typed_copy.id_ = id_;
-        }
-        else
-        {
-            typed_copy.ownership_.reset(id_->clone());
-            typed_copy.id_ = typed_copy.ownership_.get();
-        }
+        typed_copy.ownership_.capture(*id_);
+        typed_copy.id_ = &*typed_copy.ownership_;
     }
 
  private:
     id_interface const* id_;
-    std::shared_ptr<id_interface> ownership_;
+    captured_id ownership_;
 };
 inline id_ref
 ref(id_interface const& id)
@@ -217,9 +382,40 @@ ref(id_interface const& id)
     return id_ref(id);
 }
 
+namespace detail {
+
+// is_std_hashable<T>::value yields a compile-time boolean indicating whether
+// or not std::hash is enabled for T.
+template<class T, class = std::void_t<>>
+struct is_std_hashable : std::false_type
+{
+};
+template<class T>
+struct is_std_hashable<
+    T,
+    std::void_t<decltype(std::hash<T>()(std::declval<T const&>()))>>
+    : std::true_type
+{
+};
+
+// Hash a value for use as an ID. If std::hash isn't available for the value's
+// type, this falls back to a constant.
+template<class Value>
+std::size_t
+hash_id_value(Value const& value)
+{
+    if constexpr (is_std_hashable<Value>::value)
+        return std::hash<Value>()(value);
+    else
+        return 0;
+}
+
+} // namespace detail
+
 // simple_id<Value> takes a regular type (Value) and implements id_interface
 // for it. The type Value must be copyable and comparable for equality and
-// ordering (i.e., supply == and < operators).
+// ordering (i.e., supply == and < operators). If std::hash is enabled for
+// Value, it's also used to hash the ID.
 template<class Value>
 struct simple_id : id_interface
 {
@@ -231,6 +427,12 @@ struct simple_id : id_interface
     {
     }
 
+    id_type_token
+    type_token() const override
+    {
+        return get_id_type_token<simple_id>();
+    }
+
     Value const&
     value() const
     {
@@ -257,12 +459,35 @@ struct simple_id : id_interface
         return value_ < other_id.value_;
     }
 
+    std::size_t
+    hash() const override
+    {
+        return detail::hash_id_value(value_);
+    }
+
+    bool
+    hash_is_meaningful() const override
+    {
+        return detail::is_std_hashable<Value>::value;
+    }
+
     void
     deep_copy(id_interface* copy) const override
     {
         *static_cast<simple_id*>(copy) = *this;
     }
 
+    id_interface*
+    clone_in_place(void* storage, std::size_t size) const override
+    {
+        if constexpr (std::is_trivially_copyable_v<Value>)
+        {
+            if (sizeof(simple_id) <= size)
+                return new (storage) simple_id(value_);
+        }
+        return nullptr;
+    }
+
     Value value_;
 };
 
@@ -275,7 +500,9 @@ make_id(Value value)
 }
 
 // simple_id_by_reference is like simple_id but takes a pointer to the value.
-// The value is only copied if the ID is cloned or deep-copied.
+// The value is only copied if the ID is cloned or deep-copied. It's hashed
+// just like simple_id, and it can also be captured inline (along with a copy
+// of its value) if the value is small and trivially copyable.
 template<class Value>
 struct simple_id_by_reference : id_interface
 {
@@ -287,6 +514,12 @@ struct simple_id_by_reference : id_interface
     {
     }
 
+    id_type_token
+    type_token() const override
+    {
+        return get_id_type_token<simple_id_by_reference>();
+    }
+
     id_interface*
     clone() const override
     {
@@ -311,6 +544,41 @@ struct simple_id_by_reference : id_interface
         return *value_ < *other_id.value_;
     }
 
+    std::size_t
+    hash() const override
+    {
+        // This must agree with the hash of the equivalent simple_id.
+        return detail::hash_id_value(*value_);
+    }
+
+    bool
+    hash_is_meaningful() const override
+    {
+        return detail::is_std_hashable<Value>::value;
+    }
+
+    id_interface*
+    clone_in_place(void* storage, std::size_t size) const override
+    {
+        // If the value is trivially copyable, a copy of it can be placed in
+        // the storage right after the ID itself.
+        if constexpr (std::is_trivially_copyable_v<Value>)
+        {
+            std::size_t const value_offset
+                = (sizeof(simple_id_by_reference) + alignof(Value) - 1)
+                  / alignof(Value) * alignof(Value);
+            if (alignof(Value) <= alignof(std::max_align_t)
+                && value_offset + sizeof(Value) <= size)
+            {
+                Value* value_copy = new (
+                    static_cast<unsigned char*>(storage) + value_offset)
+                    Value(*value_);
+                return new (storage) simple_id_by_reference(value_copy);
+            }
+        }
+        return nullptr;
+    }
+
     void
     deep_copy(id_interface* copy) const override
     {
@@ -340,22 +608,54 @@ make_id_by_reference(Value const& value)
     return simple_id_by_reference<Value>(&value);
 }
 
-// id_pair implements the ID interface for a pair of IDs.
-template<class Id0, class Id1>
-struct id_pair : id_interface
+template<class... Ids>
+struct id_tuple;
+
+namespace detail {
+
+// is_inline_capturable_id<Id>::value yields a compile-time boolean indicating
+// whether or not IDs of type Id are always eligible for clone_in_place()
+// (given enough space).
+template<class Id>
+struct is_inline_capturable_id : std::false_type
+{
+};
+template<class Value>
+struct is_inline_capturable_id<simple_id<Value>>
+    : std::is_trivially_copyable<Value>
+{
+};
+template<class... Ids>
+struct is_inline_capturable_id<id_tuple<Ids...>>
+    : std::conjunction<is_inline_capturable_id<Ids>...>
+{
+};
+
+} // namespace detail
+
+// id_tuple implements the ID interface for a tuple of IDs.
+// All operations are applied to the component IDs in a single flat pass.
+template<class... Ids>
+struct id_tuple : id_interface
 {
-    id_pair()
+    id_tuple()
     {
     }
 
-    id_pair(Id0 id0, Id1 id1) : id0_(std::move(id0)), id1_(std::move(id1))
+    explicit id_tuple(Ids... ids) : ids_(std::move(ids)...)
     {
     }
 
+    id_type_token
+    type_token() const override
+    {
+        return get_id_type_token<id_tuple>();
+    }
+
     id_interface*
     clone() const override
     {
-        id_pair* copy = new id_pair;
+        id_tuple* copy = new id_tuple;
         this->deep_copy(copy);
         return copy;
     }
@@ -363,47 +663,114 @@ struct id_pair : id_interface
     bool
     equals(id_interface const& other) const override
     {
-        id_pair const& other_id = static_cast<id_pair const&>(other);
-        return id0_.equals(other_id.id0_) && id1_.equals(other_id.id1_);
+        return equals(
+            static_cast<id_tuple const&>(other),
+            std::index_sequence_for<Ids...>());
     }
 
     bool
     less_than(id_interface const& other) const override
     {
-        id_pair const& other_id = static_cast<id_pair const&>(other);
-        return id0_.less_than(other_id.id0_)
-               || (id0_.equals(other_id.id0_)
-                   && id1_.less_than(other_id.id1_));
+        return less_than(
+            static_cast<id_tuple const&>(other),
+            std::index_sequence_for<Ids...>());
+    }
+
+    std::size_t
+    hash() const override
+    {
+        return hash(std::index_sequence_for<Ids...>());
+    }
+
+    bool
+    hash_is_meaningful() const override
+    {
+        return hash_is_meaningful(std::index_sequence_for<Ids...>());
     }
 
     void
     deep_copy(id_interface* copy) const override
     {
-        id_pair* typed_copy = static_cast<id_pair*>(copy);
-        id0_.deep_copy(&typed_copy->id0_);
-        id1_.deep_copy(&typed_copy->id1_);
+        deep_copy(
+            *static_cast<id_tuple*>(copy), std::index_sequence_for<Ids...>());
+    }
+
+    id_interface*
+    clone_in_place(void* storage, std::size_t size) const override
+    {
+        if constexpr (detail::is_inline_capturable_id<id_tuple>::value)
+        {
+            if (sizeof(id_tuple) <= size)
+                return new (storage) id_tuple(*this);
+        }
+        return nullptr;
     }
 
  private:
-    Id0 id0_;
-    Id1 id1_;
+    template<std::size_t... Indices>
+    bool
+    equals(id_tuple const& other, std::index_sequence<Indices...>) const
+    {
+        return (
+            std::get<Indices>(ids_).equals(std::get<Indices>(other.ids_))
+            && ...);
+    }
+
+    template<std::size_t... Indices>
+    bool
+    less_than(id_tuple const& other, std::index_sequence<Indices...>) const
+    {
+        // This is a lexicographical comparison. The fold stops at the first
+        // component that differs, and that component decides the result.
+        bool result = false;
+        (void) ((std::get<Indices>(ids_).less_than(
+                     std::get<Indices>(other.ids_))
+                     ? (result = true)
+                     : !std::get<Indices>(ids_).equals(
+                         std::get<Indices>(other.ids_)))
+                || ...);
+        return result;
+    }
+
+    template<std::size_t... Indices>
+    std::size_t
+    hash(std::index_sequence<Indices...>) const
+    {
+        std::size_t result = 0;
+        ((result = combine_id_hashes(result, std::get<Indices>(ids_).hash())),
+         ...);
+        return result;
+    }
+
+    template<std::size_t... Indices>
+    bool
+    hash_is_meaningful(std::index_sequence<Indices...>) const
+    {
+        return (std::get<Indices>(ids_).hash_is_meaningful() && ...);
+    }
+
+    template<std::size_t... Indices>
+    void
+    deep_copy(id_tuple& copy, std::index_sequence<Indices...>) const
+    {
+        (std::get<Indices>(ids_).deep_copy(&std::get<Indices>(copy.ids_)),
+         ...);
+    }
+
+    std::tuple<Ids...> ids_;
 };
 
-// combine_ids(id0, id1) combines id0 and id1 into a single ID pair.
+// id_pair<Id0, Id1> is simply a two-element id_tuple.
 template<class Id0, class Id1>
-auto
-combine_ids(Id0 id0, Id1 id1)
-{
-    return id_pair<Id0, Id1>(std::move(id0), std::move(id1));
-}
+using id_pair = id_tuple<Id0, Id1>;
 
-// Combine more than two IDs into nested pairs.
-template<class Id0, class Id1, class... Rest>
+// combine_ids(ids...) combines any number of IDs into a single (flat) ID
+// tuple.
+template<class... Ids>
 auto
-combine_ids(Id0 id0, Id1 id1, Rest... rest)
+combine_ids(Ids... ids)
 {
-    return combine_ids(
-        combine_ids(std::move(id0), std::move(id1)), std::move(rest)...);
+    return id_tuple<Ids...>(std::move(ids)...);
 }
 
 // Allow combine_ids() to take a single argument for variadic purposes.
@@ -428,4 +795,17 @@ static simple_id<unit_id_type*> const unit_id(nullptr);
 
 } // namespace alia
 
+// Allow captured_ids to be used as keys in std::unordered_map, etc.
+namespace std {
+template<>
+struct hash<alia::captured_id>
+{
+    size_t
+    operator()(alia::captured_id const& id) const noexcept
+    {
+        return id.hash();
+    }
+};
+} // namespace std
+
 #endif
@@ -5,6 +5,10 @@
 #include <alia/flow/data_graph.hpp>
 #include <alia/flow/events.hpp>
 #include <alia/signals/utilities.hpp>
+#include <alia/system/shared_apply_table.hpp>
+
+#include <algorithm>
+#include <list>
 
 namespace alia {
 
@@ -311,38 +315,68 @@ process_apply_args(
     process_apply_args(ctx, data, args_ready, rest...);
 }
 
-template<class Value, class Function, class... Args>
+// Does the result of an apply need to be (re)computed?
+template<class Value>
+bool
+apply_computation_needed(apply_result_data<Value> const& data, bool args_ready)
+{
+    return (data.status == apply_status::UNCOMPUTED
+            || data.status == apply_status::MOVED)
+           && args_ready;
+}
+
+// Run :compute to fill in the result of an apply and record whether it
+// succeeded or failed. :compute is invoked with a reference to the stored
+// value.
+template<class Value, class Compute>
 void
-process_apply_body(
+run_apply_computation(apply_result_data<Value>& data, Compute&& compute)
+{
+    try
+    {
+        std::forward<Compute>(compute)(data.value);
+        data.status = apply_status::READY;
+    }
+    catch (...)
+    {
+        data.error = std::current_exception();
+        data.status = apply_status::FAILED;
+    }
+}
+
+// Do the computation for an apply (if necessary). :compute is invoked with a
+// reference to the stored value and is expected to fill it in.
+template<class Value, class Compute>
+void
+process_apply_computation(
     context ctx,
     apply_result_data<Value>& data,
     bool args_ready,
-    Function&& f,
-    Args const&... args)
+    Compute&& compute)
 {
     if (is_refresh_event(ctx))
     {
-        if ((data.status == apply_status::UNCOMPUTED
-             || data.status == apply_status::MOVED)
-            && args_ready)
-        {
-            try
-            {
-                data.value
-                    = std::forward<Function>(f)(forward_signal(args)...);
-                data.status = apply_status::READY;
-            }
-            catch (...)
-            {
-                data.error = std::current_exception();
-                data.status = apply_status::FAILED;
-            }
-        }
+        if (apply_computation_needed(data, args_ready))
+            run_apply_computation(data, std::forward<Compute>(compute));
         if (data.status == apply_status::FAILED)
             std::rethrow_exception(data.error);
     }
 }
 
+template<class Value, class Function, class... Args>
+void
+process_apply_body(
+    context ctx,
+    apply_result_data<Value>& data,
+    bool args_ready,
+    Function&& f,
+    Args const&... args)
+{
+    process_apply_computation(ctx, data, args_ready, [&](Value& value) {
+        value = std::forward<Function>(f)(forward_signal(args)...);
+    });
+}
+
 } // namespace detail
 
 template<class Function, class... Args>
@@ -368,6 +402,386 @@ lift(Function f)
     };
 }
 
+// apply_into<Value>(ctx, f, args...) is like apply(ctx, f, args...), but
+// rather than returning a new result, :f updates the previous one in place.
+// It's invoked as f(result, arg_values...), where :result is a reference to
+// the stored Value. This allows results like vectors, strings and maps to
+// keep their storage from one computation to the next.
+//
+// Note that :result can contain anything when :f is invoked (including a
+// partial result from a computation that failed or a value that was moved
+// out), so :f must always fully overwrite it. (e.g., clear() it first.)
+//
+template<class Value, class Function, class... Args>
+auto
+apply_into(context ctx, Function&& f, Args const&... args)
+{
+    detail::apply_result_data<Value>* data_ptr;
+    get_cached_data(ctx, &data_ptr);
+    auto& data = *data_ptr;
+    bool args_ready = true;
+    process_apply_args(ctx, data, args_ready, args...);
+    process_apply_computation(ctx, data, args_ready, [&](Value& value) {
+        std::forward<Function>(f)(value, forward_signal(args)...);
+    });
+    return detail::make_apply_signal(data);
+}
+
+// memoized_apply(ctx, policy, f, args...) is like apply(ctx, f, args...), but
+// rather than discarding the result whenever the inputs change, it remembers
+// a bounded number of previous results (keyed by the value IDs of :args), so
+// switching back to earlier inputs (e.g., toggling between two tabs or sort
+// orders) doesn't require recomputing them. The previous results are evicted
+// in least-recently-used order.
+//
+// :policy is either a memoization_policy (see below) or simply the number of
+// previous results to retain.
+
+// unit_memoization_cost assigns every result the same cost (1).
+struct unit_memoization_cost
+{
+    template<class Value>
+    std::size_t
+    operator()(Value const&) const
+    {
+        return 1;
+    }
+};
+
+template<class Cost = unit_memoization_cost>
+struct memoization_policy
+{
+    // the maximum total cost of the previous results to retain (in addition
+    // to the current one)
+    std::size_t capacity;
+    // a function that estimates the cost (e.g., the memory footprint) of
+    // retaining a result
+    Cost cost = Cost();
+};
+
+template<class Cost>
+memoization_policy<Cost>
+make_memoization_policy(std::size_t capacity, Cost cost)
+{
+    return memoization_policy<Cost>{capacity, std::move(cost)};
+}
+
+// statistics for a single memoized_apply call site
+struct memoization_stats
+{
+    // the number of times that the inputs changed to ones with a retained
+    // result
+    counter_type hits = 0;
+    // the number of times that the inputs changed to ones without one
+    counter_type misses = 0;
+    // the number of previous results that are currently retained
+    std::size_t entry_count = 0;
+    // the total cost of those results
+    std::size_t total_cost = 0;
+};
+
+namespace detail {
+
+template<class Value>
+struct memoized_apply_entry
+{
+    captured_id key;
+    Value value;
+    std::size_t cost;
+};
+
+template<class Value>
+struct memoized_apply_data
+{
+    // the current result
+    apply_result_data<Value> result;
+    // the combined ID of the inputs that the current result is for
+    captured_id key;
+    // previous results, most recently used first
+    std::list<memoized_apply_entry<Value>> entries;
+    memoization_stats stats;
+};
+
+// Move the current result (if it's valid) into the table of previous
+// results, evicting older ones as necessary.
+template<class Value, class Cost>
+void
+retain_memoized_result(
+    memoized_apply_data<Value>& data, memoization_policy<Cost> const& policy)
+{
+    if (data.key.is_initialized() && data.result.status == apply_status::READY)
+    {
+        std::size_t cost = policy.cost(data.result.value);
+        data.entries.push_front(memoized_apply_entry<Value>{
+            std::move(data.key), std::move(data.result.value), cost});
+        data.stats.total_cost += cost;
+        ++data.stats.entry_count;
+    }
+    while (data.stats.total_cost > policy.capacity)
+    {
+        data.stats.total_cost -= data.entries.back().cost;
+        --data.stats.entry_count;
+        data.entries.pop_back();
+    }
+    data.key.clear();
+}
+
+// Switch :data to the inputs identified by :key, restoring a previous result
+// if there is one.
+template<class Value, class Cost>
+void
+switch_memoized_inputs(
+    memoized_apply_data<Value>& data,
+    memoization_policy<Cost> const& policy,
+    id_interface const& key)
+{
+    std::size_t hash = key.hash();
+    auto match = std::find_if(
+        data.entries.begin(), data.entries.end(), [&](auto const& entry) {
+            return entry.key.matches(key, hash);
+        });
+    // Retaining the current result could evict the match, so take the match
+    // out of the table first.
+    std::list<memoized_apply_entry<Value>> found;
+    if (match != data.entries.end())
+    {
+        data.stats.total_cost -= match->cost;
+        --data.stats.entry_count;
+        found.splice(found.begin(), data.entries, match);
+    }
+
+    retain_memoized_result(data, policy);
+    reset(data.result);
+
+    if (!found.empty())
+    {
+        data.result.value = std::move(found.front().value);
+        data.result.status = apply_status::READY;
+        data.key = std::move(found.front().key);
+        ++data.stats.hits;
+    }
+    else
+    {
+        data.key.capture(key, hash);
+        ++data.stats.misses;
+    }
+}
+
+} // namespace detail
+
+template<class Value>
+struct memoized_apply_signal : apply_signal<Value>
+{
+    memoized_apply_signal(detail::memoized_apply_data<Value>& data)
+        : apply_signal<Value>(data.result), stats_(&data.stats)
+    {
+    }
+    // Get the statistics for the call site (e.g., for profiling).
+    memoization_stats const&
+    stats() const
+    {
+        return *stats_;
+    }
+
+ private:
+    memoization_stats const* stats_;
+};
+
+template<class Cost, class Function, class Arg, class... Rest>
+auto
+memoized_apply(
+    context ctx,
+    memoization_policy<Cost> const& policy,
+    Function&& f,
+    Arg const& arg,
+    Rest const&... rest)
+{
+    typedef decltype(f(forward_signal(arg), forward_signal(rest)...))
+        value_type;
+    detail::memoized_apply_data<value_type>* data_ptr;
+    get_cached_data(ctx, &data_ptr);
+    auto& data = *data_ptr;
+    bool args_ready = signal_has_value(arg) && (signal_has_value(rest) && ...);
+    if (is_refresh_event(ctx))
+    {
+        if (args_ready)
+        {
+            auto key
+                = combine_ids(ref(arg.value_id()), ref(rest.value_id())...);
+            if (!data.key.matches(key))
+                detail::switch_memoized_inputs(data, policy, key);
+        }
+        else if (data.key.is_initialized())
+        {
+            detail::retain_memoized_result(data, policy);
+            reset(data.result);
+        }
+    }
+    process_apply_body(
+        ctx, data.result, args_ready, std::forward<Function>(f), arg, rest...);
+    return memoized_apply_signal<value_type>(data);
+}
+
+template<class Function, class Arg, class... Rest>
+auto
+memoized_apply(
+    context ctx,
+    std::size_t capacity,
+    Function&& f,
+    Arg const& arg,
+    Rest const&... rest)
+{
+    return memoized_apply(
+        ctx,
+        memoization_policy<>{capacity},
+        std::forward<Function>(f),
+        arg,
+        rest...);
+}
+
+// shared_apply(ctx, f, args...) is like apply(ctx, f, args...), but the
+// result is stored in the system's shared_apply_table, keyed by the identity
+// of :f (i.e., its type) and the value IDs of :args. Any number of call sites
+// that apply the same function to the same inputs share a single computation
+// and a single stored result, which is released once the last of them is
+// gone (or moves on to other inputs).
+//
+// :f is identified by its type (or, for plain functions, its address), so
+// its behavior must be fully determined by that and the values of :args. (In
+// particular, anything that a lambda captures is ignored when matching
+// applications.) See make_function_identity_id.
+//
+// Since the result is shared, the resulting signal is read-only (rather than
+// movable).
+
+namespace detail {
+
+template<class Value>
+struct shared_apply_entry : shared_apply_entry_base
+{
+    apply_result_data<Value> result;
+};
+
+// The type of this is used to identify the function of a shared application.
+template<class Value, class Function>
+struct shared_apply_function_tag
+{
+};
+
+template<class Value>
+struct shared_apply_subscription : noncopyable
+{
+    ~shared_apply_subscription()
+    {
+        this->unsubscribe();
+    }
+
+    // Switch to the entry stored under :key (creating it if necessary).
+    void
+    subscribe(shared_apply_table& new_table, id_interface const& key)
+    {
+        // Since the key includes the value type, this cast is safe.
+        auto* new_entry = static_cast<shared_apply_entry<Value>*>(
+            acquire_shared_apply_entry(new_table, key));
+        if (!new_entry)
+        {
+            std::unique_ptr<shared_apply_entry<Value>> created(
+                new shared_apply_entry<Value>);
+            created->key.capture(key);
+            new_entry = created.get();
+            add_shared_apply_entry(new_table, std::move(created));
+            // Give the result a version that's unique within the table so
+            // that the signals of different entries never share a value ID.
+            new_entry->result.version = new_table.entry_counter;
+        }
+        this->unsubscribe();
+        table = &new_table;
+        entry = new_entry;
+    }
+
+    // Stop using the current entry (if any).
+    void
+    unsubscribe()
+    {
+        if (entry)
+        {
+            release_shared_apply_entry(*table, *entry);
+            entry = nullptr;
+        }
+    }
+
+    shared_apply_table* table = nullptr;
+    shared_apply_entry<Value>* entry = nullptr;
+    // the result that the signal refers to when there's no entry
+    apply_result_data<Value> unready;
+};
+
+} // namespace detail
+
+template<class Value>
+struct shared_apply_signal
+    : signal<shared_apply_signal<Value>, Value, read_only_signal>
+{
+    shared_apply_signal(detail::apply_result_data<Value>& data) : data_(&data)
+    {
+    }
+    id_interface const&
+    value_id() const
+    {
+        id_ = make_id(data_->version);
+        return id_;
+    }
+    bool
+    has_value() const
+    {
+        return data_->status == detail::apply_status::READY;
+    }
+    Value const&
+    read() const
+    {
+        return data_->value;
+    }
+
+ private:
+    detail::apply_result_data<Value>* data_;
+    mutable simple_id<counter_type> id_;
+};
+
+template<class Function, class... Args>
+auto
+shared_apply(context ctx, Function&& f, Args const&... args)
+{
+    typedef decltype(f(forward_signal(args)...)) value_type;
+    auto& subscription
+        = get_cached_data<detail::shared_apply_subscription<value_type>>(ctx);
+    bool args_ready = (signal_has_value(args) && ...);
+    if (is_refresh_event(ctx))
+    {
+        if (args_ready)
+        {
+            auto key = combine_ids(
+                make_function_identity_id<detail::shared_apply_function_tag<
+                    value_type,
+                    std::decay_t<Function>>>(f),
+                ref(args.value_id())...);
+            if (!subscription.entry || !subscription.entry->key.matches(key))
+            {
+                subscription.subscribe(
+                    get_shared_apply_table(get<system_tag>(ctx)), key);
+            }
+        }
+        else
+        {
+            subscription.unsubscribe();
+        }
+    }
+    auto& data = subscription.entry ? subscription.entry->result
+                                    : subscription.unready;
+    process_apply_body(
+        ctx, data, args_ready, std::forward<Function>(f), args...);
+    return shared_apply_signal<value_type>(data);
+}
+
 // duplex_apply(ctx, forward, reverse, arg), where :arg is a duplex signal,
 // yields another duplex signal whose value is the result of applying :forward
 // to the value of :arg. Writing to the resulting signal applies :reverse and
@@ -5,6 +5,18 @@
 #include <alia/flow/data_graph.hpp>
 #include <alia/flow/events.hpp>
 #include <alia/signals/utilities.hpp>
+#include <alia/system/async_cache.hpp>
+#include <alia/system/async_scheduler.hpp>
+#include <alia/system/cancellation.hpp>
+#include <alia/system/inbox.hpp>
+#include <alia/system/thread_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <vector>
 
 namespace alia {
 
@@ -27,6 +39,12 @@ struct async_operation_data
     Value result;
     // If status is FAILED, this is the error.
     std::exception_ptr error;
+    // This is used to cancel the launched operation once its result is no
+    // longer needed.
+    cancellation_source cancellation;
+    // If the operation is shared (see shared_async), these are the containers
+    // of the components that are waiting on it.
+    std::vector<component_container_ptr> observers;
 };
 
 template<class Value>
@@ -35,8 +53,26 @@ reset(async_operation_data<Value>& data)
 {
     ++data.version;
     data.status = async_status::UNREADY;
+    data.cancellation.cancel();
 }
 
+// async_operation_holder holds an async operation within the data graph. When
+// it's destroyed (because the component is no longer active), the operation
+// is cancelled and its place in the launch scheduler is released. (The data
+// itself lives on until any outstanding reporters are gone.)
+template<class Value>
+struct async_operation_holder : noncopyable
+{
+    ~async_operation_holder()
+    {
+        if (data)
+            data->cancellation.cancel();
+    }
+
+    std::shared_ptr<async_operation_data<Value>> data;
+    async_launch_request request;
+};
+
 template<class Value>
 struct async_signal : signal<async_signal<Value>, Value, read_only_signal>
 {
@@ -104,11 +140,61 @@ process_async_args(
     process_async_args(ctx, data, args_ready, rest...);
 }
 
+// async_reporter is used to report the result of an asynchronous operation.
+// If the system's inbox is being monitored (e.g., by a run_loop), the result
+// is posted to the inbox and applied on the system's own thread, so the
+// reporter can be used from any thread.
+//
+// Otherwise, the result is applied (and the system is refreshed) immediately,
+// on the calling thread. This touches the system directly, so in that case,
+// the reporter must only be used from the thread that owns the system.
+// Reporting from other threads without a monitored inbox is NOT supported.
+// (async_on_pool always goes through the inbox, so its results are safe
+// either way, but they're only delivered when the inbox is drained.)
 template<class Result>
 struct async_reporter
 {
     void
     report_success(Result result) const
+    {
+        if (inbox_is_monitored(*system_))
+        {
+            post_to_system(
+                *system_,
+                [reporter = *this,
+                 result = std::move(result)](alia::system&) mutable {
+                    reporter.apply_success(std::move(result));
+                });
+        }
+        else
+        {
+            if (apply_success(std::move(result)))
+                refresh_system(*system_);
+        }
+    }
+
+    void
+    report_failure(std::exception_ptr error) const
+    {
+        if (inbox_is_monitored(*system_))
+        {
+            post_to_system(
+                *system_, [reporter = *this, error](alia::system&) {
+                    reporter.apply_failure(error);
+                });
+        }
+        else
+        {
+            if (apply_failure(error))
+                refresh_system(*system_);
+        }
+    }
+
+    // Apply the result to the operation's data (without refreshing the
+    // system) and return whether or not it was still relevant. This must be
+    // called from the system's own thread.
+    bool
+    apply_success(Result result) const
     {
         auto& data = *data_;
         if (data.version == version_)
@@ -116,12 +202,15 @@ struct async_reporter
             data.result = std::move(result);
             data.status = async_status::COMPLETE;
             mark_dirty_component(container_);
-            refresh_system(*system_);
+            for (auto const& observer : data.observers)
+                mark_dirty_component(observer);
+            return true;
         }
+        return false;
     }
 
-    void
-    report_failure(std::exception_ptr error) const
+    bool
+    apply_failure(std::exception_ptr error) const
     {
         auto& data = *data_;
         if (data.version == version_)
@@ -129,22 +218,52 @@ struct async_reporter
             data.status = async_status::FAILED;
             data.error = error;
             mark_dirty_component(container_);
-            refresh_system(*system_);
+            for (auto const& observer : data.observers)
+                mark_dirty_component(observer);
+            return true;
         }
+        return false;
+    }
+
+    // Has the operation been cancelled? (This is true once the operation's
+    // inputs have changed or its component is no longer active. The result
+    // will be discarded anyway, so it's best to stop working on it.) This
+    // can be checked from any thread.
+    bool
+    is_cancelled() const
+    {
+        return cancellation_.is_cancelled();
     }
 
     std::shared_ptr<async_operation_data<Result>> data_;
     counter_type version_;
     alia::system* system_;
     component_container_ptr container_;
+    cancellation_token cancellation_;
 };
 
+// prioritized_async<Result>(ctx, priority, launcher, args...) is like
+// async(), but rather than launching the operation as soon as its arguments
+// are ready, it goes through the system's async_scheduler, which limits how
+// many operations can be in flight at once (see set_async_concurrency_limit).
+// Operations that have to wait are launched in order of :priority (and then
+// in the order that they arrived). :priority is re-evaluated on every
+// refresh, so a waiting operation can be re-prioritized (e.g., as its
+// component is scrolled into or out of view).
+//
+// An operation occupies its slot until its result is reported, its inputs
+// change, or its component is no longer active.
+//
 template<class Result, class Context, class Launcher, class... Args>
 auto
-async(Context ctx, Launcher launcher, Args const&... args)
+prioritized_async(
+    Context ctx,
+    async_priority priority,
+    Launcher launcher,
+    Args const&... args)
 {
-    std::shared_ptr<async_operation_data<Result>>& data_ptr
-        = get_cached_data<std::shared_ptr<async_operation_data<Result>>>(ctx);
+    auto& holder = get_cached_data<async_operation_holder<Result>>(ctx);
+    std::shared_ptr<async_operation_data<Result>>& data_ptr = holder.data;
     if (!data_ptr)
         data_ptr.reset(new async_operation_data<Result>);
     auto& data = *data_ptr;
@@ -153,15 +272,230 @@ async(Context ctx, Launcher launcher, Args const&... args)
     process_async_args(ctx, data, args_ready, args...);
 
     refresh_handler(ctx, [&](auto ctx) {
+        typedef async_launch_request::state_type request_state;
+        auto& request = holder.request;
+        // Once the launched operation is finished (or superseded), it no
+        // longer needs its slot.
+        if (request.state == request_state::RUNNING
+            && data.status != async_status::LAUNCHED)
+        {
+            detail::release_async_launch(request);
+        }
         if (data.status == async_status::UNREADY && args_ready)
+        {
+            if (detail::request_async_launch(
+                    get_async_scheduler(get<system_tag>(ctx)),
+                    request,
+                    priority,
+                    get_active_component_container(ctx),
+                    get<timing_tag>(ctx).tick_counter))
+            {
+                try
+                {
+                    auto reporter = async_reporter<Result>{
+                        data_ptr,
+                        data.version,
+                        &get<system_tag>(ctx),
+                        get_active_component_container(ctx),
+                        data.cancellation.get_token()};
+                    launcher(ctx, reporter, read_signal(args)...);
+                    data.status = async_status::LAUNCHED;
+                }
+                catch (...)
+                {
+                    data.error = std::current_exception();
+                    data.status = async_status::FAILED;
+                    detail::release_async_launch(request);
+                }
+            }
+        }
+        else if (request.state != request_state::RUNNING)
+        {
+            // If the request was waiting, it's no longer needed.
+            detail::release_async_launch(request);
+        }
+        if (data.status == async_status::FAILED)
+            std::rethrow_exception(data.error);
+    });
+
+    return make_async_signal(data);
+}
+
+template<class Result, class Context, class Launcher, class... Args>
+auto
+async(Context ctx, Launcher launcher, Args const&... args)
+{
+    return prioritized_async<Result>(
+        ctx, async_priority::NORMAL, std::move(launcher), args...);
+}
+
+namespace detail {
+
+template<class Result>
+struct shared_async_entry : async_cache_entry
+{
+    ~shared_async_entry()
+    {
+        data->cancellation.cancel();
+    }
+
+    bool
+    is_retainable() const override
+    {
+        return data->status != async_status::FAILED;
+    }
+
+    std::shared_ptr<async_operation_data<Result>> data
+        = std::make_shared<async_operation_data<Result>>();
+};
+
+// The type of this is used to identify the launcher of a shared operation.
+template<class Result, class Launcher>
+struct shared_async_launcher_tag
+{
+};
+
+} // namespace detail
+
+// shared_async_subscription is the per-call-site state of shared_async().
+template<class Result>
+struct shared_async_subscription : noncopyable
+{
+    ~shared_async_subscription()
+    {
+        this->unsubscribe();
+    }
+
+    // Switch to the entry stored under :key (creating it if necessary).
+    void
+    subscribe(
+        async_cache& new_cache,
+        id_interface const& key,
+        component_container_ptr const& new_container)
+    {
+        // Since the key includes the result type, this cast is safe.
+        auto* new_entry = static_cast<detail::shared_async_entry<Result>*>(
+            detail::find_async_cache_entry(new_cache, key));
+        if (new_entry)
+        {
+            detail::retain_async_cache_entry(new_cache, *new_entry);
+        }
+        else
+        {
+            std::unique_ptr<detail::shared_async_entry<Result>> created(
+                new detail::shared_async_entry<Result>);
+            created->key.capture(key);
+            new_entry = created.get();
+            detail::add_async_cache_entry(new_cache, std::move(created));
+            // Give the operation a version that's unique within the cache so
+            // that the signals of different entries never share a value ID.
+            new_entry->data->version = new_cache.entry_counter;
+        }
+        // The new entry is acquired before the old one is released so that
+        // they can't end up at the same address.
+        this->unsubscribe();
+        cache = &new_cache;
+        entry = new_entry;
+        container = new_container;
+        entry->data->observers.push_back(container);
+    }
+
+    // Make sure that :new_container is the one observing the entry.
+    void
+    observe(component_container_ptr const& new_container)
+    {
+        if (container != new_container)
+        {
+            auto& observers = entry->data->observers;
+            *std::find(observers.begin(), observers.end(), container)
+                = new_container;
+            container = new_container;
+        }
+    }
+
+    // Stop using the current entry (if any).
+    void
+    unsubscribe()
+    {
+        if (entry)
+        {
+            auto& observers = entry->data->observers;
+            observers.erase(
+                std::find(observers.begin(), observers.end(), container));
+            detail::release_async_cache_entry(*cache, *entry);
+            entry = nullptr;
+            container.reset();
+        }
+    }
+
+    async_cache* cache = nullptr;
+    detail::shared_async_entry<Result>* entry = nullptr;
+    // the container that's registered as an observer of the entry
+    component_container_ptr container;
+    // the data that the signal refers to when there's no entry
+    async_operation_data<Result> unready;
+};
+
+// shared_async<Result>(ctx, launcher, args...) is like async(), but the
+// operation is stored in the system's async_cache (see get_async_cache),
+// keyed by the identity of :launcher and the value IDs of :args. Any number
+// of call sites that request the same operation at the same time share a
+// single launch, and the result is delivered to all of them. Results are
+// also retained for a while after they're no longer in use (according to the
+// cache's eviction policy), so later requests can reuse them.
+//
+// :launcher is identified by its type (or, for plain functions, its
+// address), so its behavior must be fully determined by that and the values
+// of :args. (In particular, anything that a lambda captures is ignored when
+// matching requests.) See make_function_identity_id.
+//
+template<class Result, class Context, class Launcher, class... Args>
+auto
+shared_async(Context ctx, Launcher launcher, Args const&... args)
+{
+    auto& subscription
+        = get_cached_data<shared_async_subscription<Result>>(ctx);
+
+    if (is_refresh_event(ctx))
+    {
+        auto& cache = get_async_cache(get<system_tag>(ctx));
+        if ((signal_has_value(args) && ...))
+        {
+            auto key = combine_ids(
+                make_function_identity_id<
+                    detail::shared_async_launcher_tag<Result, Launcher>>(
+                    launcher),
+                ref(args.value_id())...);
+            auto const& container = get_active_component_container(ctx);
+            if (!subscription.entry || !subscription.entry->key.matches(key))
+                subscription.subscribe(cache, key, container);
+            else
+                subscription.observe(container);
+        }
+        else
+        {
+            subscription.unsubscribe();
+        }
+    }
+
+    refresh_handler(ctx, [&](auto ctx) {
+        if (!subscription.entry)
+            return;
+        auto& data_ptr = subscription.entry->data;
+        auto& data = *data_ptr;
+        if (data.status == async_status::UNREADY)
         {
             try
             {
+                // The results of shared operations are delivered to the
+                // entry's observers, so the reporter has no container of its
+                // own.
                 auto reporter = async_reporter<Result>{
                     data_ptr,
                     data.version,
                     &get<system_tag>(ctx),
-                    get_active_component_container(ctx)};
+                    nullptr,
+                    data.cancellation.get_token()};
                 launcher(ctx, reporter, read_signal(args)...);
                 data.status = async_status::LAUNCHED;
             }
@@ -175,7 +509,389 @@ async(Context ctx, Launcher launcher, Args const&... args)
             std::rethrow_exception(data.error);
     });
 
-    return make_async_signal(data);
+    return make_async_signal(
+        subscription.entry ? *subscription.entry->data
+                           : subscription.unready);
+}
+
+namespace detail {
+
+// Invoke a pooled function, passing it the operation's cancellation token if
+// it accepts one.
+template<class Function, class... Args>
+auto
+invoke_pooled_function(
+    Function& function, cancellation_token const& token, Args&... args)
+{
+    if constexpr (std::is_invocable<Function&, cancellation_token, Args&...>::
+                      value)
+    {
+        return function(token, args...);
+    }
+    else
+    {
+        return function(args...);
+    }
+}
+
+} // namespace detail
+
+// async_on_pool(ctx, function, args...) is like async(), but rather than a
+// launcher, it takes a function that computes the result directly from the
+// values of :args. That function is run on the system's thread pool (see
+// get_thread_pool), and the result is handed back to the system's own thread
+// through its inbox. Thus, the system must either be driven by a run_loop or
+// have process_inbox() called regularly. Results that arrive together are
+// applied with a single refresh.
+//
+// If the operation is cancelled (see async_reporter::is_cancelled) before
+// the pool gets to it, it's dropped without running. If :function accepts a
+// cancellation_token as its first argument, it's also given the operation's
+// token so that it can stop early.
+//
+// Note that :function (and the values of :args) are copied to the pool, so
+// they must be safe to use from another thread.
+//
+// The task holds a reporter for the operation, and if the task is dropped
+// (because it's cancelled before it runs or the pool shuts down), the
+// reporter is destroyed on a worker thread. This is safe because the
+// reporter's references to the operation are all shared_ptrs. If the worker
+// ends up releasing the last of them, the system is no longer using the
+// operation, so nothing on the system's thread can be touching it. (However,
+// it does mean that the result type must be safe to destroy on any thread.)
+//
+template<class Context, class Function, class... Args>
+auto
+async_on_pool(Context ctx, Function function, Args const&... args)
+{
+    typedef std::decay_t<decltype(detail::invoke_pooled_function(
+        function,
+        std::declval<cancellation_token const&>(),
+        std::declval<typename Args::value_type&>()...))>
+        result_type;
+    return async<result_type>(
+        ctx,
+        [&](auto ctx, auto reporter, auto const&... arg_values) {
+            cancellation_token token = reporter.cancellation_;
+            get_thread_pool(get<system_tag>(ctx))
+                .submit(
+                    [function, reporter, arg_values...]() mutable {
+                        // The reporter is copied (rather than moved) into
+                        // the posted message, so if posting fails, it's
+                        // still intact for reporting that failure.
+                        alia::system& sys = *reporter.system_;
+                        try
+                        {
+                            auto result = detail::invoke_pooled_function(
+                                function,
+                                reporter.cancellation_,
+                                arg_values...);
+                            post_to_system(
+                                sys,
+                                [reporter, result = std::move(result)](
+                                    alia::system&) mutable {
+                                    reporter.apply_success(std::move(result));
+                                });
+                        }
+                        catch (...)
+                        {
+                            post_to_system(
+                                sys,
+                                [reporter, error = std::current_exception()](
+                                    alia::system&) {
+                                    reporter.apply_failure(error);
+                                });
+                        }
+                    },
+                    token);
+        },
+        args...);
+}
+
+namespace detail {
+
+template<class Value>
+struct background_apply_data
+{
+    // the status of the computation for the current inputs
+    async_status status = async_status::UNREADY;
+    // This is incremented every time the inputs change.
+    counter_type input_version = 0;
+    // This identifies the current value. It's incremented every time a new
+    // value is swapped in.
+    counter_type value_version = 0;
+    bool has_value = false;
+    // Is the value from an earlier set of inputs?
+    bool stale = false;
+    Value value;
+    // If status is FAILED, this is the error.
+    std::exception_ptr error;
+    cancellation_source cancellation;
+
+    // If a worker can't post its result back to the system (e.g., because it
+    // runs out of memory while doing so), it leaves the error here instead,
+    // and it's picked up on the next refresh. (These are shared with the
+    // workers, so they're protected by undelivered_mutex.)
+    std::atomic<bool> has_undelivered_error{false};
+    std::mutex undelivered_mutex;
+    counter_type undelivered_version = 0;
+    std::exception_ptr undelivered_error;
+};
+
+// Record that the result for :version couldn't be delivered because of
+// :error. This is called from the worker.
+template<class Value>
+void
+record_undelivered_background_apply(
+    background_apply_data<Value>& data,
+    counter_type version,
+    std::exception_ptr error)
+{
+    std::lock_guard<std::mutex> lock(data.undelivered_mutex);
+    data.undelivered_version = version;
+    data.undelivered_error = std::move(error);
+    data.has_undelivered_error = true;
+}
+
+// If the result for the current inputs couldn't be delivered, mark the
+// computation as failed.
+template<class Value>
+void
+collect_undelivered_background_apply(background_apply_data<Value>& data)
+{
+    if (!data.has_undelivered_error)
+        return;
+    std::lock_guard<std::mutex> lock(data.undelivered_mutex);
+    if (data.status == async_status::LAUNCHED
+        && data.undelivered_version == data.input_version)
+    {
+        data.error = data.undelivered_error;
+        data.status = async_status::FAILED;
+    }
+    data.undelivered_error = nullptr;
+    data.has_undelivered_error = false;
+}
+
+template<class Value>
+struct background_apply_holder : noncopyable
+{
+    ~background_apply_holder()
+    {
+        if (data)
+            data->cancellation.cancel();
+    }
+
+    std::shared_ptr<background_apply_data<Value>> data;
+};
+
+template<class Value>
+void
+invalidate_background_apply(background_apply_data<Value>& data)
+{
+    ++data.input_version;
+    data.status = async_status::UNREADY;
+    data.cancellation.cancel();
+    data.stale = data.has_value;
+}
+
+template<class Value>
+void
+process_background_apply_args(context, background_apply_data<Value>&, bool&)
+{
+}
+template<class Value, class Arg, class... Rest>
+void
+process_background_apply_args(
+    context ctx,
+    background_apply_data<Value>& data,
+    bool& args_ready,
+    Arg const& arg,
+    Rest const&... rest)
+{
+    captured_id* cached_id;
+    get_cached_data(ctx, &cached_id);
+    if (is_refresh_event(ctx))
+    {
+        if (!signal_has_value(arg))
+        {
+            args_ready = false;
+        }
+        else if (!cached_id->matches(arg.value_id()))
+        {
+            invalidate_background_apply(data);
+            cached_id->capture(arg.value_id());
+        }
+    }
+    process_background_apply_args(ctx, data, args_ready, rest...);
+}
+
+} // namespace detail
+
+template<class Value>
+struct background_apply_signal
+    : signal<background_apply_signal<Value>, Value, read_only_signal>
+{
+    background_apply_signal(detail::background_apply_data<Value>& data)
+        : data_(&data)
+    {
+    }
+    id_interface const&
+    value_id() const
+    {
+        id_ = make_id(data_->value_version);
+        return id_;
+    }
+    bool
+    has_value() const
+    {
+        return data_->has_value;
+    }
+    Value const&
+    read() const
+    {
+        return data_->value;
+    }
+    // Is the value from an earlier set of inputs (while the result for the
+    // current ones is being computed)?
+    bool
+    is_stale() const
+    {
+        return data_->stale;
+    }
+
+ private:
+    detail::background_apply_data<Value>* data_;
+    mutable simple_id<counter_type> id_;
+};
+
+// background_apply(ctx, f, args...) is like apply(ctx, f, args...), but :f is
+// run on the system's thread pool (as with async_on_pool), so expensive
+// computations don't hold up the refresh pass. While a new result is being
+// computed, the signal keeps the previous result, and its is_stale() method
+// reports that the value doesn't reflect the current inputs. Once the new
+// result arrives, it's swapped in, and only the calling component is marked
+// for refresh.
+//
+// As with async_on_pool, the system must either be driven by a run_loop or
+// have process_inbox() called regularly, and :f (and the values of :args)
+// must be safe to use from another thread. If :f accepts a
+// cancellation_token as its first argument, it's given one that's cancelled
+// once its result is no longer needed.
+//
+// If :f throws, the exception is rethrown from background_apply() (as with
+// apply()) until the inputs change. The same goes for errors in delivering
+// the result back to the system (e.g., running out of memory), but since
+// those leave no message behind, they're only noticed on the next refresh.
+//
+template<class Function, class... Args>
+auto
+background_apply(context ctx, Function function, Args const&... args)
+{
+    typedef std::decay_t<decltype(detail::invoke_pooled_function(
+        function,
+        std::declval<cancellation_token const&>(),
+        std::declval<typename Args::value_type&>()...))>
+        value_type;
+    typedef detail::background_apply_data<value_type> data_type;
+
+    std::shared_ptr<data_type>& data_ptr
+        = get_cached_data<detail::background_apply_holder<value_type>>(ctx)
+              .data;
+    if (!data_ptr)
+        data_ptr.reset(new data_type);
+    auto& data = *data_ptr;
+
+    bool args_ready = true;
+    detail::process_background_apply_args(ctx, data, args_ready, args...);
+
+    refresh_handler(ctx, [&](auto ctx) {
+        if (!args_ready)
+        {
+            // Without inputs, there's nothing meaningful to show.
+            if (data.has_value || data.status != async_status::UNREADY)
+            {
+                detail::invalidate_background_apply(data);
+                data.has_value = data.stale = false;
+                ++data.value_version;
+            }
+            return;
+        }
+        if (data.status == async_status::UNREADY)
+        {
+            alia::system& sys = get<system_tag>(ctx);
+            cancellation_token token = data.cancellation.get_token();
+            // If the task is dropped, the data and the container are
+            // released on a worker thread. As with async_on_pool, that's
+            // safe because they're only held through shared_ptrs.
+            get_thread_pool(sys).submit(
+                [function,
+                 token,
+                 data = data_ptr,
+                 version = data.input_version,
+                 container = get_active_component_container(ctx),
+                 &sys,
+                 arg_values
+                 = std::make_tuple(read_signal(args)...)]() mutable {
+                    std::optional<value_type> result;
+                    std::exception_ptr error;
+                    try
+                    {
+                        result = std::apply(
+                            [&](auto&... values) {
+                                return detail::invoke_pooled_function(
+                                    function, token, values...);
+                            },
+                            arg_values);
+                    }
+                    catch (...)
+                    {
+                        error = std::current_exception();
+                    }
+                    // data and container are copied (rather than moved)
+                    // into the posted message, so if posting fails, data is
+                    // still intact for recording that failure.
+                    try
+                    {
+                        post_to_system(
+                            sys,
+                            [data,
+                             version,
+                             container,
+                             result = std::move(result),
+                             error](alia::system&) mutable {
+                                if (data->input_version != version)
+                                    return;
+                                if (error)
+                                {
+                                    data->error = error;
+                                    data->status = async_status::FAILED;
+                                }
+                                else
+                                {
+                                    data->value = std::move(*result);
+                                    data->has_value = true;
+                                    data->stale = false;
+                                    ++data->value_version;
+                                    data->status = async_status::COMPLETE;
+                                }
+                                mark_dirty_component(container);
+                            });
+                    }
+                    catch (...)
+                    {
+                        detail::record_undelivered_background_apply(
+                            *data, version, std::current_exception());
+                    }
+                },
+                token);
+            data.status = async_status::LAUNCHED;
+        }
+        detail::collect_undelivered_background_apply(data);
+        if (data.status == async_status::FAILED)
+            std::rethrow_exception(data.error);
+    });
+
+    return background_apply_signal<value_type>(data);
 }
 
 } // namespace alia
@@ -0,0 +1,150 @@
+#include <alia/signals/parallel_apply.hpp>
+
+#include <alia/system/internals.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+namespace alia {
+
+namespace {
+
+// the state shared by the threads that are working on a batch of deferred
+// computations
+struct parallel_apply_batch
+{
+    std::vector<std::function<void()>> computations;
+    std::atomic<std::size_t> next{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::size_t finished_count = 0;
+};
+
+// Claim and run computations from :batch until there are none left.
+void
+work_on_batch(parallel_apply_batch& batch)
+{
+    std::size_t const total = batch.computations.size();
+    std::size_t count = 0;
+    std::size_t index;
+    while ((index = batch.next++) < total)
+    {
+        // The computations catch their own exceptions.
+        batch.computations[index]();
+        ++count;
+    }
+    if (count != 0)
+    {
+        std::lock_guard<std::mutex> lock(batch.mutex);
+        batch.finished_count += count;
+        if (batch.finished_count == total)
+            batch.finished.notify_all();
+    }
+}
+
+} // namespace
+
+parallel_apply_scope::~parallel_apply_scope()
+{
+    if (traversal_)
+    {
+        // If the traversal is being unwound by an exception, the recorded
+        // computations are simply dropped. (They'll be recorded again on the
+        // next pass.)
+        if (std::uncaught_exceptions() > uncaught_exceptions_)
+            discard();
+        end();
+    }
+}
+
+void
+parallel_apply_scope::begin(context ctx)
+{
+    system_ = &get<system_tag>(ctx);
+    traversal_ = &get_event_traversal(ctx);
+    parent_ = traversal_->parallel_scope;
+    traversal_->parallel_scope = this;
+    uncaught_exceptions_ = std::uncaught_exceptions();
+}
+
+void
+parallel_apply_scope::join()
+{
+    if (computations_.empty())
+        return;
+
+    auto batch = std::make_shared<parallel_apply_batch>();
+    batch->computations = std::move(computations_);
+    computations_.clear();
+    std::size_t const total = batch->computations.size();
+
+    // The current thread works on the batch too, so it only needs help if
+    // there's more than one computation.
+    thread_pool& pool = get_thread_pool(*system_);
+    std::size_t helper_count = std::min(std::size_t(pool.size()), total - 1);
+    for (std::size_t i = 0; i != helper_count; ++i)
+        pool.submit([batch] { work_on_batch(*batch); });
+    work_on_batch(*batch);
+    {
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->finished.wait(
+            lock, [&] { return batch->finished_count == total; });
+    }
+
+    for (auto const& container : containers_)
+        mark_dirty_component(container);
+    containers_.clear();
+}
+
+void
+parallel_apply_scope::discard()
+{
+    computations_.clear();
+    containers_.clear();
+}
+
+void
+parallel_apply_scope::end()
+{
+    if (traversal_)
+    {
+        // Similarly, if the traversal has been aborted (without an
+        // exception), its results would be thrown away anyway. (Work that
+        // was recorded before the abortion has already been discarded, but
+        // the code that follows an exception-free abortion can still record
+        // more.)
+        if (traversal_->aborted)
+            discard();
+        join();
+        traversal_->parallel_scope = parent_;
+        traversal_ = nullptr;
+    }
+}
+
+namespace detail {
+
+void
+discard_parallel_apply_work(event_traversal& traversal)
+{
+    for (parallel_apply_scope* scope = traversal.parallel_scope; scope;
+         scope = scope->parent_)
+    {
+        scope->discard();
+    }
+}
+
+} // namespace detail
+
+void
+parallel_apply_scope::defer(
+    std::function<void()> computation,
+    component_container_ptr const& container)
+{
+    computations_.push_back(std::move(computation));
+    containers_.push_back(container);
+}
+
+} // namespace alia
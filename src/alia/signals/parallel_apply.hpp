@@ -0,0 +1,118 @@
+#ifndef ALIA_SIGNALS_PARALLEL_APPLY_HPP
+#define ALIA_SIGNALS_PARALLEL_APPLY_HPP
+
+#include <alia/signals/application.hpp>
+
+#include <functional>
+#include <tuple>
+#include <vector>
+
+// This file provides a way to evaluate independent apply() bodies
+// concurrently within a single refresh pass.
+//
+// parallel_apply(ctx, f, args...) is like apply(ctx, f, args...), except that
+// when it's invoked within a parallel_apply_scope, the computation isn't done
+// on the spot. Instead, it's recorded, and all the computations recorded
+// within the scope are run concurrently (on the system's thread pool) when
+// the scope ends (its join point). Thus, the results are filled in for the
+// code that follows the scope. (Within the scope, the signals simply don't
+// have values yet.) The components of the deferred computations are also
+// marked dirty, so the next pass sees the results everywhere, and failures
+// are rethrown from the call sites exactly as with apply().
+//
+// Outside of a parallel_apply_scope, parallel_apply() is just apply().
+//
+// Since :f runs on other threads, it must be pure (or at least thread-safe).
+// It's copied (along with the values of :args) when the computation is
+// deferred.
+//
+
+namespace alia {
+
+struct parallel_apply_scope : noncopyable
+{
+    parallel_apply_scope()
+    {
+    }
+    parallel_apply_scope(context ctx)
+    {
+        begin(ctx);
+    }
+    ~parallel_apply_scope();
+
+    void
+    begin(context ctx);
+
+    // Run the computations that have been recorded so far and wait for them
+    // to finish. (This is done automatically when the scope ends, unless it's
+    // ending because of an exception or the traversal has been aborted.
+    // Aborting the traversal also discards the computations that have been
+    // recorded up to that point.)
+    void
+    join();
+
+    // Drop the computations that have been recorded so far (without running
+    // them).
+    void
+    discard();
+
+    void
+    end();
+
+    // Record a computation to run at the join point. :container is the
+    // component that it's for.
+    void
+    defer(
+        std::function<void()> computation,
+        component_container_ptr const& container);
+
+ private:
+    friend void
+    detail::discard_parallel_apply_work(event_traversal& traversal);
+
+    system* system_ = nullptr;
+    event_traversal* traversal_ = nullptr;
+    parallel_apply_scope* parent_ = nullptr;
+    int uncaught_exceptions_ = 0;
+    std::vector<std::function<void()>> computations_;
+    std::vector<component_container_ptr> containers_;
+};
+
+template<class Function, class... Args>
+auto
+parallel_apply(context ctx, Function&& f, Args const&... args)
+{
+    typedef decltype(f(forward_signal(args)...)) value_type;
+    detail::apply_result_data<value_type>* data_ptr;
+    get_cached_data(ctx, &data_ptr);
+    auto& data = *data_ptr;
+    bool args_ready = true;
+    process_apply_args(ctx, data, args_ready, args...);
+
+    parallel_apply_scope* scope = get_event_traversal(ctx).parallel_scope;
+    if (scope && is_refresh_event(ctx)
+        && detail::apply_computation_needed(data, args_ready))
+    {
+        // The signal shouldn't have a value until the computation is done.
+        data.status = detail::apply_status::UNCOMPUTED;
+        scope->defer(
+            [&data,
+             f = std::decay_t<Function>(std::forward<Function>(f)),
+             arg_values = std::make_tuple(read_signal(args)...)]() mutable {
+                detail::run_apply_computation(data, [&](value_type& value) {
+                    value = std::apply(f, arg_values);
+                });
+            },
+            get_active_component_container(ctx));
+    }
+    else
+    {
+        process_apply_body(
+            ctx, data, args_ready, std::forward<Function>(f), args...);
+    }
+    return detail::make_apply_signal(data);
+}
+
+} // namespace alia
+
+#endif
@@ -3,6 +3,11 @@
 
 #include <alia/signals/core.hpp>
 
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <typeinfo>
+
 // This file defines various utilities for working with signals.
 // (These are mostly meant to be used internally.)
 
@@ -309,6 +314,56 @@ struct lazy_signal_wrapper
     mutable Value value_;
 };
 
+// make_function_identity_id<Tag>(f) makes an ID that identifies the function
+// :f for the purpose of sharing its results across call sites (e.g., in
+// shared_apply and shared_async). A function object is identified by its type
+// (along with :Tag). Plain functions with the same signature all share a
+// type, so they're also identified by their addresses.
+//
+// Type-erasing wrappers (like std::function) hide the identity of the
+// function that they wrap, so they can't be used this way. std::function
+// itself is rejected at compile time.
+
+namespace detail {
+
+template<class T>
+struct is_std_function : std::false_type
+{
+};
+template<class Signature>
+struct is_std_function<std::function<Signature>> : std::true_type
+{
+};
+
+} // namespace detail
+
+template<class Tag, class Function>
+auto
+make_function_identity_id(Function const& f)
+{
+    static_assert(
+        !detail::is_std_function<Function>::value,
+        "std::function hides the identity of the function that it wraps");
+    if constexpr (std::is_function_v<Function>)
+    {
+        return combine_ids(
+            make_id(&typeid(Tag)),
+            make_id(reinterpret_cast<std::uintptr_t>(&f)));
+    }
+    else if constexpr (
+        std::is_pointer_v<Function>
+        && std::is_function_v<std::remove_pointer_t<Function>>)
+    {
+        return combine_ids(
+            make_id(&typeid(Tag)),
+            make_id(reinterpret_cast<std::uintptr_t>(f)));
+    }
+    else
+    {
+        return make_id(&typeid(Tag));
+    }
+}
+
 } // namespace alia
 
 #endif
@@ -0,0 +1,93 @@
+#include <alia/system/async_cache.hpp>
+
+#include <alia/system/internals.hpp>
+
+namespace alia {
+
+async_cache&
+get_async_cache(system& sys)
+{
+    return sys.async_results;
+}
+
+namespace detail {
+
+static void
+evict_async_cache_entry(async_cache& cache, async_cache_entry& entry)
+{
+    if (entry.unreferenced_position != cache.unreferenced.end())
+        cache.unreferenced.erase(entry.unreferenced_position);
+    // Note that this destroys the entry (and thus cancels its operation), so
+    // the entry's own key can't be used for the erasure.
+    cache.entries.erase(cache.entries.find(entry.key));
+}
+
+static void
+prune_async_cache(async_cache& cache)
+{
+    while (!cache.unreferenced.empty()
+           && (cache.unreferenced.size() > cache.max_unreferenced_entries
+               || cache.now - cache.unreferenced.front()->release_time
+                      > cache.max_unreferenced_age))
+    {
+        evict_async_cache_entry(cache, *cache.unreferenced.front());
+    }
+}
+
+async_cache_entry*
+find_async_cache_entry(async_cache& cache, id_interface const& key)
+{
+    if (cache.entries.empty())
+        return nullptr;
+    auto i = cache.entries.find(captured_id(key));
+    return i != cache.entries.end() ? i->second.get() : nullptr;
+}
+
+async_cache_entry&
+add_async_cache_entry(
+    async_cache& cache, std::unique_ptr<async_cache_entry> entry)
+{
+    auto& added = *entry;
+    added.reference_count = 1;
+    added.unreferenced_position = cache.unreferenced.end();
+    cache.entries[added.key] = std::move(entry);
+    ++cache.entry_counter;
+    return added;
+}
+
+void
+retain_async_cache_entry(async_cache& cache, async_cache_entry& entry)
+{
+    if (entry.reference_count++ == 0)
+    {
+        cache.unreferenced.erase(entry.unreferenced_position);
+        entry.unreferenced_position = cache.unreferenced.end();
+    }
+}
+
+void
+release_async_cache_entry(async_cache& cache, async_cache_entry& entry)
+{
+    if (--entry.reference_count != 0)
+        return;
+    if (!entry.is_retainable())
+    {
+        evict_async_cache_entry(cache, entry);
+        return;
+    }
+    entry.release_time = cache.now;
+    entry.unreferenced_position
+        = cache.unreferenced.insert(cache.unreferenced.end(), &entry);
+    prune_async_cache(cache);
+}
+
+void
+update_async_cache(async_cache& cache, millisecond_count now)
+{
+    cache.now = now;
+    prune_async_cache(cache);
+}
+
+} // namespace detail
+
+} // namespace alia
@@ -0,0 +1,105 @@
+#ifndef ALIA_SYSTEM_ASYNC_CACHE_HPP
+#define ALIA_SYSTEM_ASYNC_CACHE_HPP
+
+#include <alia/common.hpp>
+#include <alia/id.hpp>
+#include <alia/timing/ticks.hpp>
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+// This file defines the system-wide cache that allows identical asynchronous
+// requests to share a single operation (see shared_async).
+
+namespace alia {
+
+struct system;
+
+namespace detail {
+
+struct async_cache_entry
+{
+    virtual ~async_cache_entry()
+    {
+    }
+
+    // Is the entry's result worth keeping once nothing references it?
+    // (Failed operations aren't, since the next request should retry them.)
+    virtual bool
+    is_retainable() const
+        = 0;
+
+    // the key that the entry is stored under
+    captured_id key;
+    // the number of call sites that are currently using the entry
+    std::size_t reference_count = 0;
+    // the cache time at which the entry last became unreferenced
+    millisecond_count release_time = 0;
+    // If the entry is unreferenced, this is its position in the cache's list
+    // of unreferenced entries. (Otherwise, it's the end of that list.)
+    std::list<async_cache_entry*>::iterator unreferenced_position;
+};
+
+} // namespace detail
+
+// async_cache holds the results of shared asynchronous operations. Entries are
+// reference-counted by the call sites that use them. Once an entry is no
+// longer referenced, it's retained (so that its result can be reused) until
+// it's either pushed out by more recently released entries or outlives its
+// time-to-live. (Expiration is checked at the start of each refresh.)
+// Evicting an entry cancels its operation if it's still in progress.
+struct async_cache : noncopyable
+{
+    // the maximum number of unreferenced entries to retain
+    std::size_t max_unreferenced_entries = 64;
+    // how long (in milliseconds) to retain unreferenced entries
+    millisecond_count max_unreferenced_age = 60000;
+
+    // all entries, referenced or not
+    std::unordered_map<captured_id, std::unique_ptr<detail::async_cache_entry>>
+        entries;
+    // unreferenced entries, least recently released first
+    std::list<detail::async_cache_entry*> unreferenced;
+    // the tick count at the start of the most recent refresh
+    millisecond_count now = 0;
+    // the number of entries that have ever been added (This is used to give
+    // each entry a unique identity.)
+    counter_type entry_counter = 0;
+};
+
+// Get the shared async cache for :sys.
+async_cache&
+get_async_cache(system& sys);
+
+namespace detail {
+
+// Find the entry stored under :key (or return nullptr if there isn't one).
+async_cache_entry*
+find_async_cache_entry(async_cache& cache, id_interface const& key);
+
+// Add :entry to the cache. (Its key must already be set.) The entry starts
+// out referenced by the caller. This also increments the cache's
+// entry_counter.
+async_cache_entry&
+add_async_cache_entry(
+    async_cache& cache, std::unique_ptr<async_cache_entry> entry);
+
+// Add a reference to :entry.
+void
+retain_async_cache_entry(async_cache& cache, async_cache_entry& entry);
+
+// Remove a reference to :entry. This may evict it (or others).
+void
+release_async_cache_entry(async_cache& cache, async_cache_entry& entry);
+
+// Update the cache's sense of the current time and evict any unreferenced
+// entries that have expired.
+void
+update_async_cache(async_cache& cache, millisecond_count now);
+
+} // namespace detail
+
+} // namespace alia
+
+#endif
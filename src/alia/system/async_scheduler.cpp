@@ -0,0 +1,161 @@
+#include <alia/system/async_scheduler.hpp>
+
+#include <alia/system/internals.hpp>
+
+namespace alia {
+
+static bool
+has_free_slot(async_scheduler const& scheduler)
+{
+    return scheduler.max_concurrent_launches == 0
+           || scheduler.active_count < scheduler.max_concurrent_launches;
+}
+
+static void
+remove_from_queue(async_scheduler& scheduler, async_launch_request& request)
+{
+    unsigned index = unsigned(request.priority);
+    scheduler.queues[index].erase(request.position);
+    --scheduler.stats[index].queue_depth;
+}
+
+static void
+add_to_queue(async_scheduler& scheduler, async_launch_request& request)
+{
+    unsigned index = unsigned(request.priority);
+    auto& queue = scheduler.queues[index];
+    request.position = queue.insert(queue.end(), &request);
+    auto& stats = scheduler.stats[index];
+    ++stats.queue_depth;
+    if (stats.queue_depth > stats.peak_queue_depth)
+        stats.peak_queue_depth = stats.queue_depth;
+}
+
+// Hand out any free slots to the highest priority waiting requests.
+static void
+grant_free_slots(async_scheduler& scheduler)
+{
+    for (auto& queue : scheduler.queues)
+    {
+        while (!queue.empty())
+        {
+            if (!has_free_slot(scheduler))
+                return;
+            async_launch_request& request = *queue.front();
+            remove_from_queue(scheduler, request);
+            request.state = async_launch_request::state_type::GRANTED;
+            ++scheduler.active_count;
+            mark_dirty_component(request.container);
+        }
+    }
+}
+
+async_launch_request::~async_launch_request()
+{
+    detail::release_async_launch(*this);
+}
+
+async_scheduler&
+get_async_scheduler(system& sys)
+{
+    return sys.launch_scheduler;
+}
+
+void
+set_async_concurrency_limit(system& sys, unsigned limit)
+{
+    auto& scheduler = get_async_scheduler(sys);
+    scheduler.max_concurrent_launches = limit;
+    grant_free_slots(scheduler);
+}
+
+async_priority_stats const&
+get_async_priority_stats(system& sys, async_priority priority)
+{
+    return get_async_scheduler(sys).stats[unsigned(priority)];
+}
+
+namespace detail {
+
+bool
+request_async_launch(
+    async_scheduler& scheduler,
+    async_launch_request& request,
+    async_priority priority,
+    component_container_ptr const& container,
+    millisecond_count now)
+{
+    typedef async_launch_request::state_type state_type;
+    switch (request.state)
+    {
+        case state_type::IDLE: {
+            request.scheduler = &scheduler;
+            request.priority = priority;
+            request.container = container;
+            request.enqueue_time = now;
+            // Launch immediately if there's a free slot and nothing of equal
+            // or higher priority is already waiting for one.
+            bool waiters_ahead = false;
+            for (unsigned i = 0; i <= unsigned(priority); ++i)
+                waiters_ahead = waiters_ahead || !scheduler.queues[i].empty();
+            if (!waiters_ahead && has_free_slot(scheduler))
+            {
+                ++scheduler.active_count;
+                break;
+            }
+            request.state = state_type::WAITING;
+            add_to_queue(scheduler, request);
+            return false;
+        }
+        case state_type::WAITING:
+            request.container = container;
+            if (request.priority != priority)
+            {
+                remove_from_queue(scheduler, request);
+                request.priority = priority;
+                add_to_queue(scheduler, request);
+            }
+            return false;
+        case state_type::GRANTED:
+            break;
+        case state_type::RUNNING:
+            // The caller is relaunching in the slot that it already has.
+            request.enqueue_time = now;
+            break;
+    }
+
+    request.state = state_type::RUNNING;
+    auto& stats = scheduler.stats[unsigned(request.priority)];
+    ++stats.launches;
+    millisecond_count wait = now - request.enqueue_time;
+    stats.total_wait += wait;
+    if (wait > stats.max_wait)
+        stats.max_wait = wait;
+    return true;
+}
+
+void
+release_async_launch(async_launch_request& request)
+{
+    typedef async_launch_request::state_type state_type;
+    auto* scheduler = request.scheduler;
+    switch (request.state)
+    {
+        case state_type::IDLE:
+            return;
+        case state_type::WAITING:
+            remove_from_queue(*scheduler, request);
+            break;
+        case state_type::GRANTED:
+        case state_type::RUNNING:
+            --scheduler->active_count;
+            grant_free_slots(*scheduler);
+            break;
+    }
+    request.state = state_type::IDLE;
+    request.container.reset();
+}
+
+} // namespace detail
+
+} // namespace alia
@@ -0,0 +1,130 @@
+#ifndef ALIA_SYSTEM_ASYNC_SCHEDULER_HPP
+#define ALIA_SYSTEM_ASYNC_SCHEDULER_HPP
+
+#include <alia/common.hpp>
+#include <alia/flow/components.hpp>
+#include <alia/timing/ticks.hpp>
+
+#include <list>
+
+// This file defines the scheduling layer that sits between async() and its
+// launchers. It limits how many operations a system has in flight at once
+// and decides which waiting operations to launch first.
+
+namespace alia {
+
+struct system;
+
+enum class async_priority
+{
+    HIGH,
+    NORMAL,
+    LOW
+};
+
+static constexpr unsigned async_priority_count = 3;
+
+// statistics for a single priority class
+struct async_priority_stats
+{
+    // the number of operations that are currently waiting to launch
+    std::size_t queue_depth = 0;
+    // the largest that queue_depth has ever been
+    std::size_t peak_queue_depth = 0;
+    // the number of operations that have been launched
+    counter_type launches = 0;
+    // the total time (in milliseconds) that launched operations spent waiting
+    millisecond_count total_wait = 0;
+    // the longest time that any launched operation spent waiting
+    millisecond_count max_wait = 0;
+};
+
+struct async_scheduler;
+
+// async_launch_request tracks a single call site's progress through the
+// scheduler. It's stored alongside the operation that it's for and releases
+// its place in the scheduler when it's destroyed.
+struct async_launch_request : noncopyable
+{
+    enum class state_type
+    {
+        // not known to the scheduler
+        IDLE,
+        // waiting for a slot
+        WAITING,
+        // given a slot but not yet launched
+        GRANTED,
+        // launched and occupying a slot
+        RUNNING
+    };
+
+    ~async_launch_request();
+
+    async_scheduler* scheduler = nullptr;
+    state_type state = state_type::IDLE;
+    async_priority priority = async_priority::NORMAL;
+    // when the request started waiting
+    millisecond_count enqueue_time = 0;
+    // the component to wake up when the request is granted a slot
+    component_container_ptr container;
+    // the request's position in its priority queue (if WAITING)
+    std::list<async_launch_request*>::iterator position;
+};
+
+struct async_scheduler : noncopyable
+{
+    // the maximum number of operations that can be in flight at once (or 0
+    // for no limit) - Use set_async_concurrency_limit to change this.
+    unsigned max_concurrent_launches = 0;
+    // the number of slots that are occupied by operations that are running
+    // or about to launch
+    unsigned active_count = 0;
+    // waiting requests for each priority class, in the order they arrived
+    std::list<async_launch_request*> queues[async_priority_count];
+    async_priority_stats stats[async_priority_count];
+};
+
+// Get the async scheduler for :sys.
+async_scheduler&
+get_async_scheduler(system& sys);
+
+// Set the maximum number of async operations that :sys can have in flight at
+// once. (0 means there's no limit.) If this frees up slots, the components
+// that are given them are marked dirty, so the system should be refreshed
+// afterwards.
+void
+set_async_concurrency_limit(system& sys, unsigned limit);
+
+// Get the statistics for the priority class :priority in :sys.
+async_priority_stats const&
+get_async_priority_stats(system& sys, async_priority priority);
+
+namespace detail {
+
+// Ask for permission to launch the operation associated with :request. If
+// this returns true, the caller must launch the operation (or call
+// release_async_launch() if it can't). Otherwise, the request waits in the
+// scheduler, and its component will be marked dirty when it's granted a
+// slot.
+//
+// If the request is already waiting, this updates its priority (and moves it
+// to the back of its new queue if that's changed).
+//
+bool
+request_async_launch(
+    async_scheduler& scheduler,
+    async_launch_request& request,
+    async_priority priority,
+    component_container_ptr const& container,
+    millisecond_count now);
+
+// Release whatever place :request has in its scheduler (if any). This frees
+// up its slot for other requests.
+void
+release_async_launch(async_launch_request& request);
+
+} // namespace detail
+
+} // namespace alia
+
+#endif
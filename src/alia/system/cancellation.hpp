@@ -0,0 +1,71 @@
+#ifndef ALIA_SYSTEM_CANCELLATION_HPP
+#define ALIA_SYSTEM_CANCELLATION_HPP
+
+#include <atomic>
+#include <memory>
+
+// This file defines a simple mechanism for telling asynchronous work that its
+// result is no longer needed.
+
+namespace alia {
+
+struct cancellation_state
+{
+    std::atomic<bool> cancelled{false};
+};
+
+// A cancellation_token is given to asynchronous work so that it can check
+// whether or not it's been cancelled. Tokens are cheap to copy and safe to
+// check from any thread. A default-constructed token is never cancelled.
+struct cancellation_token
+{
+    cancellation_token()
+    {
+    }
+
+    explicit cancellation_token(std::shared_ptr<cancellation_state> state)
+        : state_(std::move(state))
+    {
+    }
+
+    bool
+    is_cancelled() const
+    {
+        return state_ && state_->cancelled.load(std::memory_order_relaxed);
+    }
+
+ private:
+    std::shared_ptr<cancellation_state> state_;
+};
+
+// A cancellation_source issues tokens and cancels them.
+struct cancellation_source
+{
+    // Get a token that will be cancelled the next time cancel() is called.
+    cancellation_token
+    get_token()
+    {
+        if (!state_)
+            state_ = std::make_shared<cancellation_state>();
+        return cancellation_token(state_);
+    }
+
+    // Cancel all tokens that have been issued so far. (Tokens that are
+    // issued after this are unaffected.)
+    void
+    cancel()
+    {
+        if (state_)
+        {
+            state_->cancelled.store(true, std::memory_order_relaxed);
+            state_.reset();
+        }
+    }
+
+ private:
+    std::shared_ptr<cancellation_state> state_;
+};
+
+} // namespace alia
+
+#endif
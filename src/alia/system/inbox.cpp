@@ -0,0 +1,123 @@
+#include <alia/system/inbox.hpp>
+
+#include <alia/system/internals.hpp>
+
+namespace alia {
+
+static void
+delete_inbox_messages(detail::inbox_message* message)
+{
+    while (message)
+    {
+        detail::inbox_message* next = message->next;
+        delete message;
+        message = next;
+    }
+}
+
+system_inbox::~system_inbox()
+{
+    delete_inbox_messages(head.exchange(nullptr));
+    delete_inbox_messages(pending);
+}
+
+namespace detail {
+
+void
+post_inbox_message(system_inbox& inbox, inbox_message* message)
+{
+    // Note that once the message is in the inbox, the consumer can take it
+    // at any time, so we can't look at it after that.
+    inbox_message* previous = inbox.head.load(std::memory_order_relaxed);
+    do
+    {
+        message->next = previous;
+    } while (!inbox.head.compare_exchange_weak(
+        previous,
+        message,
+        std::memory_order_release,
+        std::memory_order_relaxed));
+    // If the inbox was empty, the consumer might be waiting for something to
+    // do.
+    if (!previous)
+    {
+        // Hold our own reference to the waker so that it stays alive even if
+        // it's removed from the inbox while we're using it.
+        if (auto waker = get_inbox_waker(inbox))
+            waker->wake();
+    }
+}
+
+} // namespace detail
+
+void
+set_inbox_waker(system_inbox& inbox, std::shared_ptr<inbox_waker> waker)
+{
+    std::atomic_store(&inbox.waker, std::move(waker));
+}
+
+std::shared_ptr<inbox_waker>
+get_inbox_waker(system_inbox const& inbox)
+{
+    return std::atomic_load(&inbox.waker);
+}
+
+std::size_t
+drain_inbox(system_inbox& inbox, system& sys)
+{
+    detail::inbox_message* newest
+        = inbox.head.exchange(nullptr, std::memory_order_acquire);
+
+    // Reverse the list so that the messages are delivered in order.
+    detail::inbox_message* oldest = nullptr;
+    while (newest)
+    {
+        detail::inbox_message* next = newest->next;
+        newest->next = oldest;
+        oldest = newest;
+        newest = next;
+    }
+
+    // Add them to the end of the pending list. (This is normally empty, but
+    // if a message threw an exception during the last drain, the ones after
+    // it are still there.)
+    detail::inbox_message** tail = &inbox.pending;
+    while (*tail)
+        tail = &(*tail)->next;
+    *tail = oldest;
+
+    std::size_t count = 0;
+    while (inbox.pending)
+    {
+        std::unique_ptr<detail::inbox_message> message(inbox.pending);
+        inbox.pending = message->next;
+        ++count;
+        message->deliver(sys);
+    }
+    return count;
+}
+
+std::size_t
+process_inbox(system& sys)
+{
+    std::size_t count = drain_inbox(sys.inbox, sys);
+    if (has_queued_events(sys.queued_events))
+        process_event_batch(sys);
+    else if (count != 0)
+        refresh_system(sys);
+    return count;
+}
+
+system_inbox&
+get_inbox(system& sys)
+{
+    return sys.inbox;
+}
+
+bool
+inbox_is_monitored(system& sys)
+{
+    return get_inbox_waker(sys.inbox) != nullptr;
+}
+
+} // namespace alia
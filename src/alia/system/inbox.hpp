@@ -0,0 +1,174 @@
+#ifndef ALIA_SYSTEM_INBOX_HPP
+#define ALIA_SYSTEM_INBOX_HPP
+
+#include <alia/flow/events.hpp>
+
+#include <atomic>
+#include <memory>
+
+// This file defines the inbox that allows other threads to send work to a
+// system. Any thread can post to the inbox, but only the thread that owns the
+// system should drain it. (This is typically done by a run loop. See
+// run_loop.hpp.)
+
+namespace alia {
+
+struct system;
+
+namespace detail {
+
+struct inbox_message
+{
+    virtual ~inbox_message()
+    {
+    }
+
+    virtual void
+    deliver(system& sys)
+        = 0;
+
+    inbox_message* next = nullptr;
+};
+
+template<class Function>
+struct function_inbox_message : inbox_message
+{
+    explicit function_inbox_message(Function function)
+        : function(std::move(function))
+    {
+    }
+
+    void
+    deliver(system& sys) override
+    {
+        function(sys);
+    }
+
+    Function function;
+};
+
+} // namespace detail
+
+// inbox_waker is implemented by whatever is responsible for draining an inbox
+// (e.g., a run loop). It's shared with the threads that post to the inbox, so
+// it must be safe to call from any thread, and it must stay usable for as
+// long as any of them hold a reference to it (even after it has been removed
+// from the inbox).
+struct inbox_waker
+{
+    virtual ~inbox_waker()
+    {
+    }
+
+    virtual void
+    wake()
+        = 0;
+};
+
+// system_inbox is a lock-free, multiple-producer, single-consumer queue of
+// messages for a system.
+struct system_inbox : noncopyable
+{
+    ~system_inbox();
+
+    // the most recently posted message - Messages are linked from newest to
+    // oldest, and the consumer reverses them when it drains the inbox.
+    std::atomic<detail::inbox_message*> head{nullptr};
+
+    // messages that have been taken from the above but not yet delivered,
+    // from oldest to newest - This is only accessed by the consumer.
+    detail::inbox_message* pending = nullptr;
+
+    // If this is set, it's woken (on the posting thread) whenever a message
+    // is posted to an empty inbox, so that whoever is responsible for
+    // draining the inbox can wake up. Posting threads access this
+    // concurrently, so it must only be accessed through set_inbox_waker() and
+    // get_inbox_waker().
+    std::shared_ptr<inbox_waker> waker;
+};
+
+// Set the waker for :inbox. This can be called while other threads are
+// posting. Any that are already in the middle of waking the old waker keep
+// their own references to it, so it's only destroyed once they're done.
+void
+set_inbox_waker(system_inbox& inbox, std::shared_ptr<inbox_waker> waker);
+
+// Get the current waker for :inbox (or null if there isn't one).
+std::shared_ptr<inbox_waker>
+get_inbox_waker(system_inbox const& inbox);
+
+namespace detail {
+
+// Post :message to :inbox. (The inbox takes ownership of it.)
+void
+post_inbox_message(system_inbox& inbox, inbox_message* message);
+
+} // namespace detail
+
+// Deliver all messages in :inbox to :sys, in the order in which they were
+// posted, and return the number of messages delivered.
+//
+// This must only be called from the thread that owns :sys.
+//
+std::size_t
+drain_inbox(system_inbox& inbox, system& sys);
+
+// Drain the inbox for :sys, deliver the events that were posted to it (as a
+// batch), and refresh the system (once) if anything was delivered. Return the
+// number of messages that were drained.
+//
+// This is what a run loop does whenever it wakes up, so it's only needed if
+// :sys isn't being driven by one.
+//
+std::size_t
+process_inbox(system& sys);
+
+// Get the inbox for :sys.
+system_inbox&
+get_inbox(system& sys);
+
+// Is anyone monitoring the inbox for :sys (i.e., is it being drained
+// automatically)?
+bool
+inbox_is_monitored(system& sys);
+
+// Post :function to the inbox for :sys. It will be called as function(sys)
+// (on the thread that owns :sys) when the inbox is drained, and the system
+// will be refreshed afterwards. This can be called from any thread.
+template<class Function>
+void
+post_to_system(system& sys, Function function)
+{
+    detail::post_inbox_message(
+        get_inbox(sys),
+        new detail::function_inbox_message<Function>(std::move(function)));
+}
+
+// Post an untargeted event to :sys. It will be delivered as part of the
+// batch of events that follows the next time the inbox is drained. (See
+// queue_event.) This can be called from any thread.
+template<class Event>
+void
+post_event(system& sys, Event event)
+{
+    post_to_system(sys, [event = std::move(event)](system& sys) mutable {
+        queue_event(sys, std::move(event));
+    });
+}
+
+// Post an event to be delivered to :target within :sys. (See post_event.)
+template<class Event>
+void
+post_targeted_event(system& sys, Event event, external_component_id target)
+{
+    post_to_system(
+        sys,
+        [event = std::move(event),
+         target = std::move(target)](system& sys) mutable {
+            queue_targeted_event(sys, std::move(event), target);
+        });
+}
+
+} // namespace alia
+
+#endif
@@ -18,11 +18,22 @@ refresh_system(system& sys)
     sys.refresh_needed = false;
     ++sys.refresh_counter;
 
+    // Expire any shared async results that have been unused for too long.
+    detail::update_async_cache(
+        sys.async_results, sys.external->get_tick_count());
+
     int pass_count = 0;
     while (true)
     {
-        refresh_event refresh;
-        detail::dispatch_event(sys, refresh);
+        if (sys.incremental_refresh && !sys.root_component->reentry_needed)
+        {
+            detail::refresh_isolated_components(sys);
+        }
+        else
+        {
+            refresh_event refresh;
+            detail::dispatch_event(sys, refresh);
+        }
         if (!sys.root_component->dirty)
             break;
         ++pass_count;
@@ -1,6 +1,7 @@
 #ifndef ALIA_SYSTEM_INTERFACE_HPP
 #define ALIA_SYSTEM_INTERFACE_HPP
 
+#include <exception>
 #include <functional>
 
 namespace alia {
@@ -32,6 +32,24 @@ initialize_system(
     sys.external.reset(
         external ? external : new default_external_interface(sys));
     sys.root_component.reset(new component_container);
+    // The first refresh always has to run the whole controller.
+    sys.root_component->reentry_needed = true;
+}
+
+void
+request_full_refresh(system& sys)
+{
+    sys.root_component->reentry_needed = true;
+}
+
+void
+process_event_batch(system& sys)
+{
+    if (!has_queued_events(sys.queued_events))
+        return;
+    deliver_queued_events(sys.queued_events, sys);
+    ++sys.queued_events.metrics.batches;
+    refresh_system(sys);
 }
 
 void
@@ -3,10 +3,18 @@
 
 #include <functional>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include <alia/context/interface.hpp>
 #include <alia/flow/data_graph.hpp>
+#include <alia/flow/event_queue.hpp>
 #include <alia/flow/events.hpp>
+#include <alia/system/async_cache.hpp>
+#include <alia/system/async_scheduler.hpp>
+#include <alia/system/inbox.hpp>
+#include <alia/system/shared_apply_table.hpp>
+#include <alia/system/thread_pool.hpp>
 #include <alia/timing/scheduler.hpp>
 #include <alia/timing/ticks.hpp>
 
@@ -79,14 +87,67 @@ struct default_external_interface : external_interface
 
 struct system : noncopyable
 {
+    // isolated components that need to be re-entered by the next incremental
+    // refresh (see below) - This can contain null and stale entries.
+    // (This is declared before the data graph so that it outlives the
+    // components that are stored there.)
+    std::vector<component_reentry_point*> pending_reentries;
+    // handlers for targeted events that can be delivered without a traversal
+    // (See direct_targeted_event_handler.)
+    // (This is also declared before the data graph for the same reason.)
+    std::unordered_multimap<component_id, detail::direct_event_handler_node*>
+        direct_event_handlers;
+    // results of shared asynchronous operations (see shared_async)
+    // (This is also declared before the data graph for the same reason.)
+    async_cache async_results;
+    // limits and priorities for async launches (see prioritized_async)
+    // (This is also declared before the data graph for the same reason.)
+    async_scheduler launch_scheduler;
+    // results of shared applications (see shared_apply)
+    // (This is also declared before the data graph for the same reason.)
+    shared_apply_table shared_applications;
     data_graph data;
     std::function<void(context)> controller;
     bool refresh_needed = false;
     counter_type refresh_counter = 0;
     std::unique_ptr<external_interface> external;
     timer_event_scheduler scheduler;
+    // events waiting to be delivered in the next batch (see queue_event)
+    event_queue queued_events;
+    // work that other threads have posted to this system (see post_to_system)
+    system_inbox inbox;
+    // the thread pool for async_on_pool to use - If this is null, the default
+    // pool is used.
+    thread_pool* pool = nullptr;
+    // the system's reference to the default pool (once it's used it)
+    // (This is declared after the inbox so that the pool's workers are
+    // finished before the inbox is destroyed.)
+    std::shared_ptr<thread_pool> default_pool;
     component_container_ptr root_component;
     std::function<void(std::exception_ptr)> error_handler;
+    // If this is set, pure components (see invoke_pure_component) trust that
+    // matching content fingerprints (hashes) imply matching content IDs and
+    // skip the full ID comparison. Content IDs whose hashes aren't meaningful
+    // (see id_interface::hash_is_meaningful) are always compared in full.
+    // Note that this accepts staleness due to hash collisions: If the new
+    // content ID differs from the old one but happens to have the same hash,
+    // the change is missed, and the component isn't refreshed.
+    bool trust_content_fingerprints = false;
+    // If this is set, refresh_system only re-enters the isolated components
+    // that have changed (see invoke_isolated_component) rather than running
+    // the whole controller, unless something has changed outside of any
+    // isolated component. This is only correct if all changes to application
+    // state are made through alia (e.g., via state signals), since those are
+    // the only changes that alia can track. Other changes require a full
+    // refresh, which can be requested via request_full_refresh().
+    bool incremental_refresh = false;
+    // If this is set, abort_traversal() flags the event traversal as aborted
+    // rather than throwing an exception, and the rest of the traversal is
+    // short-circuited by the control flow constructs. Note that this means
+    // that the code immediately following a call to abort_traversal() (up to
+    // the next control flow construct) still runs, so it shouldn't assume
+    // otherwise.
+    bool exception_free_abortion = false;
 };
 
 void
@@ -95,6 +156,49 @@ initialize_system(
     std::function<void(context)> const& controller,
     external_interface* external = nullptr);
 
+// Request that the next refresh of :sys run the whole controller, even if
+// incremental refreshes are enabled.
+void
+request_full_refresh(system& sys);
+
+// Set the coalescing policy for events of type Event that are queued for
+// :sys. (See event_coalescing.)
+template<class Event>
+void
+set_event_coalescing(system& sys, event_coalescing policy)
+{
+    set_event_coalescing<Event>(sys.queued_events, policy);
+}
+
+// Queue an untargeted event for delivery to :sys in the next batch.
+template<class Event>
+void
+queue_event(system& sys, Event event)
+{
+    queue_event(sys.queued_events, std::move(event));
+}
+
+// Queue an event for delivery to :target in the next batch.
+template<class Event>
+void
+queue_targeted_event(system& sys, Event event, external_component_id target)
+{
+    queue_targeted_event(sys.queued_events, std::move(event), target);
+}
+
+// Deliver all events that are queued for :sys and then refresh it once.
+// (Unlike dispatch_event, the system isn't refreshed between events.)
+// If there are no queued events, this does nothing.
+void
+process_event_batch(system& sys);
+
+// Get the metrics for the event queue of :sys.
+inline event_queue_metrics const&
+get_event_queue_metrics(system const& sys)
+{
+    return sys.queued_events.metrics;
+}
+
 // timer event
 struct timer_event : targeted_event
 {
@@ -0,0 +1,131 @@
+#ifdef __linux__
+
+#include <alia/system/run_loop.hpp>
+
+#include <alia/system/interface.hpp>
+
+#include <cstdint>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace alia {
+
+namespace detail {
+
+struct run_loop_waker : inbox_waker
+{
+    run_loop_waker()
+    {
+        fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (fd < 0)
+            throw exception("run_loop: unable to create eventfd");
+    }
+
+    ~run_loop_waker()
+    {
+        close(fd);
+    }
+
+    void
+    wake() override
+    {
+        std::uint64_t one = 1;
+        // If this fails, it's because the counter is already (absurdly)
+        // high, so the loop will wake up anyway.
+        ALIA_UNUSED auto written = write(fd, &one, sizeof(one));
+    }
+
+    int fd;
+};
+
+} // namespace detail
+
+run_loop::run_loop(system& sys)
+    : sys_(&sys), waker_(std::make_shared<detail::run_loop_waker>())
+{
+    set_inbox_waker(sys.inbox, waker_);
+    // Posting threads only wake the loop when the inbox goes from empty to
+    // nonempty, so if messages arrived before the waker was published, no
+    // one is going to wake us for them. (Checking after publishing ensures
+    // that any message that we miss here will trigger the new waker.)
+    if (sys.inbox.head.load(std::memory_order_acquire))
+        waker_->wake();
+}
+
+run_loop::~run_loop()
+{
+    // Unpublish the waker. Threads that are already using it hold their own
+    // references, so the eventfd stays open until they're done.
+    set_inbox_waker(sys_->inbox, nullptr);
+}
+
+void
+run_loop::wake()
+{
+    waker_->wake();
+}
+
+void
+run_loop::stop()
+{
+    stop_requested_ = true;
+    wake();
+}
+
+void
+run_loop::run()
+{
+    while (!stop_requested_)
+        run_once();
+    stop_requested_ = false;
+}
+
+void
+run_loop::run_once(int max_wait)
+{
+    system& sys = *sys_;
+
+    // Figure out how long we can wait.
+    int timeout = max_wait;
+    auto limit_timeout = [&](millisecond_count limit) {
+        if (timeout < 0 || int(limit) < timeout)
+            timeout = int(limit);
+    };
+    if (sys.inbox.pending || has_queued_events(sys.queued_events))
+        limit_timeout(0);
+    if (system_needs_refresh(sys))
+        limit_timeout(animation_frame_interval);
+    if (has_scheduled_events(sys.scheduler))
+    {
+        limit_timeout(get_time_until_next_event(
+            sys.scheduler, sys.external->get_tick_count()));
+    }
+
+    pollfd wake_poll;
+    wake_poll.fd = waker_->fd;
+    wake_poll.events = POLLIN;
+    wake_poll.revents = 0;
+    if (poll(&wake_poll, 1, timeout) > 0)
+    {
+        // Reset the eventfd counter. (We're about to drain the inbox, so any
+        // wakeups that led to this are taken care of.)
+        std::uint64_t count;
+        ALIA_UNUSED auto read_size
+            = read(waker_->fd, &count, sizeof(count));
+    }
+
+    bool active = drain_inbox(sys.inbox, sys) != 0;
+
+    process_internal_timing_events(sys, sys.external->get_tick_count());
+
+    if (has_queued_events(sys.queued_events))
+        process_event_batch(sys);
+    else if (active || system_needs_refresh(sys))
+        refresh_system(sys);
+}
+
+} // namespace alia
+
+#endif
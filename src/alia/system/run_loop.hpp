@@ -0,0 +1,67 @@
+#ifndef ALIA_SYSTEM_RUN_LOOP_HPP
+#define ALIA_SYSTEM_RUN_LOOP_HPP
+
+#ifdef __linux__
+
+#include <alia/system/internals.hpp>
+
+#include <atomic>
+#include <memory>
+
+// This file defines a run loop that can drive a system on Linux. The thread
+// that runs the loop owns the system. Other threads interact with it by
+// posting to its inbox (see inbox.hpp).
+
+namespace alia {
+
+namespace detail {
+struct run_loop_waker;
+}
+
+struct run_loop : noncopyable
+{
+    // Attach a run loop to :sys. (The system must already be initialized,
+    // and it must use the default external interface if it relies on timer
+    // events.)
+    explicit run_loop(system& sys);
+
+    ~run_loop();
+
+    // Run the loop until stop() is called.
+    void
+    run();
+
+    // Wait for something to do and do it. Specifically, this blocks until
+    // the inbox is non-empty, the next timer event is due, an animation
+    // frame is due, or :max_wait milliseconds have passed (if :max_wait is
+    // non-negative). It then drains the inbox, issues any timer events that
+    // are ready, delivers the batch of queued events, and refreshes the
+    // system (once) if anything happened.
+    void
+    run_once(int max_wait = -1);
+
+    // Ask the loop to stop. This can be called from any thread.
+    void
+    stop();
+
+    // the interval at which the system is refreshed while it's animating
+    millisecond_count animation_frame_interval = 16;
+
+ private:
+    void
+    wake();
+
+    system* sys_;
+    // the waker that owns the eventfd that's used to wake the loop - This is
+    // shared with the inbox (and any threads that are in the middle of
+    // posting to it), so the eventfd is only closed once they're all done
+    // with it.
+    std::shared_ptr<detail::run_loop_waker> waker_;
+    std::atomic<bool> stop_requested_{false};
+};
+
+} // namespace alia
+
+#endif
+
+#endif
@@ -0,0 +1,51 @@
+#include <alia/system/shared_apply_table.hpp>
+
+#include <alia/system/internals.hpp>
+
+namespace alia {
+
+shared_apply_table&
+get_shared_apply_table(system& sys)
+{
+    return sys.shared_applications;
+}
+
+namespace detail {
+
+shared_apply_entry_base*
+acquire_shared_apply_entry(shared_apply_table& table, id_interface const& key)
+{
+    if (table.entries.empty())
+        return nullptr;
+    auto i = table.entries.find(captured_id(key));
+    if (i == table.entries.end())
+        return nullptr;
+    ++i->second->reference_count;
+    return i->second.get();
+}
+
+void
+add_shared_apply_entry(
+    shared_apply_table& table, std::unique_ptr<shared_apply_entry_base> entry)
+{
+    entry->reference_count = 1;
+    auto& key = entry->key;
+    table.entries[key] = std::move(entry);
+    ++table.entry_counter;
+}
+
+void
+release_shared_apply_entry(
+    shared_apply_table& table, shared_apply_entry_base& entry)
+{
+    if (--entry.reference_count == 0)
+    {
+        // This destroys the entry, so the entry's own key can't be used for
+        // the erasure.
+        table.entries.erase(table.entries.find(entry.key));
+    }
+}
+
+} // namespace detail
+
+} // namespace alia
@@ -0,0 +1,75 @@
+#ifndef ALIA_SYSTEM_SHARED_APPLY_TABLE_HPP
+#define ALIA_SYSTEM_SHARED_APPLY_TABLE_HPP
+
+#include <alia/common.hpp>
+#include <alia/id.hpp>
+
+#include <memory>
+#include <unordered_map>
+
+// This file defines the system-wide table that allows identical applications
+// of a function (anywhere in the traversal) to share a single result (see
+// shared_apply).
+
+namespace alia {
+
+struct system;
+
+namespace detail {
+
+struct shared_apply_entry_base
+{
+    virtual ~shared_apply_entry_base()
+    {
+    }
+
+    // the key that the entry is stored under
+    captured_id key;
+    // the number of call sites that are currently using the entry
+    std::size_t reference_count = 0;
+};
+
+} // namespace detail
+
+// shared_apply_table holds the shared results. Entries are reference-counted
+// by the call sites that use them and are destroyed as soon as the last one
+// lets go.
+struct shared_apply_table : noncopyable
+{
+    std::unordered_map<
+        captured_id,
+        std::unique_ptr<detail::shared_apply_entry_base>>
+        entries;
+    // the number of entries that have ever been added (This is used to give
+    // each entry a unique identity.)
+    counter_type entry_counter = 0;
+};
+
+// Get the shared apply table for :sys.
+shared_apply_table&
+get_shared_apply_table(system& sys);
+
+namespace detail {
+
+// Find the entry stored under :key and add a reference to it. (If there isn't
+// one, this returns nullptr.)
+shared_apply_entry_base*
+acquire_shared_apply_entry(shared_apply_table& table, id_interface const& key);
+
+// Add :entry to the table. (Its key must already be set.) The entry starts
+// out referenced by the caller. This also increments the table's
+// entry_counter.
+void
+add_shared_apply_entry(
+    shared_apply_table& table, std::unique_ptr<shared_apply_entry_base> entry);
+
+// Remove a reference to :entry, destroying it if it's no longer used.
+void
+release_shared_apply_entry(
+    shared_apply_table& table, shared_apply_entry_base& entry);
+
+} // namespace detail
+
+} // namespace alia
+
+#endif
@@ -0,0 +1,201 @@
+#include <alia/system/thread_pool.hpp>
+
+#include <alia/system/internals.hpp>
+
+#include <algorithm>
+
+namespace alia {
+
+// the pool that the current thread is a worker for (if any), and its index
+// within that pool
+static thread_local thread_pool* current_pool = nullptr;
+static thread_local unsigned current_worker = 0;
+
+thread_pool::thread_pool(unsigned thread_count)
+{
+    if (thread_count == 0)
+        thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned i = 0; i != thread_count; ++i)
+        queues_.emplace_back(new task_queue);
+    for (unsigned i = 0; i != thread_count; ++i)
+        threads_.emplace_back([this, i] { this->work(i); });
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+    for (auto& thread : threads_)
+        thread.join();
+}
+
+void
+thread_pool::submit(std::function<void()> task)
+{
+    submit(std::move(task), cancellation_token());
+}
+
+void
+thread_pool::submit(std::function<void()> task, cancellation_token token)
+{
+    // Tasks submitted by a worker go to its own queue, where it's likely to
+    // pick them up itself. Others are spread across the queues.
+    unsigned index = current_pool == this
+                         ? current_worker
+                         : next_queue_++ % unsigned(queues_.size());
+    ++unfinished_count_;
+    {
+        auto& queue = *queues_[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(queued_task{std::move(task), std::move(token)});
+        ++queued_count_;
+    }
+    // A worker that's going to sleep registers itself in sleeping_count_
+    // before it checks queued_count_ (and we do the opposite), so either it
+    // sees the new task or we see it. In the latter case, acquiring its mutex
+    // ensures that it's actually waiting before we notify it.
+    if (sleeping_count_ != 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+        }
+        work_available_.notify_one();
+    }
+}
+
+bool
+thread_pool::take_task(unsigned index, queued_task& task)
+{
+    unsigned const queue_count = unsigned(queues_.size());
+    for (unsigned i = 0; i != queue_count; ++i)
+    {
+        auto& queue = *queues_[(index + i) % queue_count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            // Take from the back of our own queue and the front of others.
+            if (i == 0)
+            {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            else
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            --queued_count_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+thread_pool::run_task(queued_task& task)
+{
+    if (!task.token.is_cancelled())
+    {
+        try
+        {
+            task.function();
+        }
+        catch (...)
+        {
+            report_error(std::current_exception());
+        }
+    }
+    // Destroy the task before we report it as finished.
+    task = queued_task();
+    if (--unfinished_count_ == 0)
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        idle_.notify_all();
+    }
+}
+
+void
+thread_pool::report_error(std::exception_ptr error)
+{
+    std::function<void(std::exception_ptr)> handler;
+    {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        handler = error_handler_;
+    }
+    if (!handler)
+        std::terminate();
+    handler(error);
+}
+
+void
+thread_pool::work(unsigned index)
+{
+    current_pool = this;
+    current_worker = index;
+    while (true)
+    {
+        queued_task task;
+        if (take_task(index, task))
+        {
+            run_task(task);
+            continue;
+        }
+
+        // There's nothing to do, so sleep until there is (or until the pool
+        // is stopping and there's nothing left).
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        ++sleeping_count_;
+        work_available_.wait(
+            lock, [&] { return stopping_ || queued_count_ != 0; });
+        --sleeping_count_;
+        if (stopping_ && queued_count_ == 0)
+            return;
+    }
+}
+
+void
+thread_pool::wait_until_idle()
+{
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle_.wait(lock, [&] { return unfinished_count_ == 0; });
+}
+
+void
+thread_pool::set_error_handler(
+    std::function<void(std::exception_ptr)> handler)
+{
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    error_handler_ = std::move(handler);
+}
+
+std::shared_ptr<thread_pool>
+get_default_thread_pool()
+{
+    // Only a weak reference is held here, so the pool's lifetime is up to
+    // its users.
+    static std::mutex mutex;
+    static std::weak_ptr<thread_pool> default_pool;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<thread_pool> pool = default_pool.lock();
+    if (!pool)
+    {
+        pool = std::make_shared<thread_pool>();
+        default_pool = pool;
+    }
+    return pool;
+}
+
+thread_pool&
+get_thread_pool(system& sys)
+{
+    if (sys.pool)
+        return *sys.pool;
+    if (!sys.default_pool)
+        sys.default_pool = get_default_thread_pool();
+    return *sys.default_pool;
+}
+
+} // namespace alia
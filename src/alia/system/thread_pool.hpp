@@ -0,0 +1,137 @@
+#ifndef ALIA_SYSTEM_THREAD_POOL_HPP
+#define ALIA_SYSTEM_THREAD_POOL_HPP
+
+#include <alia/common.hpp>
+#include <alia/system/cancellation.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// This file defines a work-stealing thread pool for running background work
+// (e.g., for async_on_pool).
+
+namespace alia {
+
+struct system;
+
+struct thread_pool : noncopyable
+{
+    // Create a pool with :thread_count worker threads. (If :thread_count is 0,
+    // this uses one thread per hardware thread.)
+    explicit thread_pool(unsigned thread_count = 0);
+
+    // This finishes any tasks that are still queued before returning.
+    ~thread_pool();
+
+    // Submit a task to be run on one of the worker threads. This can be
+    // called from any thread (including the workers themselves).
+    //
+    // Exceptions that escape from tasks are passed to the pool's error
+    // handler (see set_error_handler). If there's no error handler, they
+    // terminate the program (just as they would for a plain std::thread).
+    //
+    void
+    submit(std::function<void()> task);
+
+    // Submit a task that's dropped (without running) if :token is cancelled
+    // before a worker gets to it.
+    void
+    submit(std::function<void()> task, cancellation_token token);
+
+    // Block until all submitted tasks have finished.
+    void
+    wait_until_idle();
+
+    // Set the handler for exceptions that escape from tasks. Note that it's
+    // invoked on the worker thread that ran the task.
+    void
+    set_error_handler(std::function<void(std::exception_ptr)> handler);
+
+    // Get the number of worker threads.
+    unsigned
+    size() const
+    {
+        return unsigned(threads_.size());
+    }
+
+ private:
+    // Each worker has its own queue of tasks. A worker takes tasks from the
+    // back of its own queue, and when that's empty, it steals from the front
+    // of the other queues.
+    struct queued_task
+    {
+        std::function<void()> function;
+        cancellation_token token;
+    };
+    struct task_queue
+    {
+        std::mutex mutex;
+        std::deque<queued_task> tasks;
+    };
+
+    void
+    work(unsigned index);
+
+    bool
+    take_task(unsigned index, queued_task& task);
+
+    void
+    run_task(queued_task& task);
+
+    void
+    report_error(std::exception_ptr error);
+
+    std::vector<std::unique_ptr<task_queue>> queues_;
+    std::vector<std::thread> threads_;
+    // the queue that the next task submitted from outside the pool goes to
+    std::atomic<unsigned> next_queue_{0};
+
+    // the number of tasks that are sitting in the queues - This is only
+    // changed while holding the lock for the queue in question, so it's never
+    // nonzero without a task actually being there.
+    std::atomic<std::size_t> queued_count_{0};
+    // the number of tasks that have been submitted but not yet finished
+    std::atomic<std::size_t> unfinished_count_{0};
+    std::atomic<bool> stopping_{false};
+
+    // Workers that can't find anything to do sleep on work_available_.
+    // sleeping_count_ lets submit() skip the notification when no one is
+    // sleeping (which is the common case when the pool is busy).
+    std::mutex sleep_mutex_;
+    std::condition_variable work_available_;
+    std::atomic<unsigned> sleeping_count_{0};
+
+    // wait_until_idle() waits on this.
+    std::mutex idle_mutex_;
+    std::condition_variable idle_;
+
+    std::mutex error_mutex_;
+    std::function<void(std::exception_ptr)> error_handler_;
+};
+
+// Get the process-wide default thread pool.
+//
+// The default pool is created on demand and destroyed (joining its workers)
+// once nothing holds a reference to it anymore. Systems that use it hold a
+// reference until they're destroyed, so it's shut down along with the last
+// of them rather than during static destruction, where its tasks could run
+// into objects that have already been destroyed.
+//
+std::shared_ptr<thread_pool>
+get_default_thread_pool();
+
+// Get the thread pool that :sys uses for async_on_pool. (This is the default
+// pool unless another one has been assigned to the system.)
+thread_pool&
+get_thread_pool(system& sys);
+
+} // namespace alia
+
+#endif
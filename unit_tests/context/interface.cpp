@@ -16,6 +16,15 @@ ALIA_DEFINE_TAGGED_TYPE(other_traversal_tag, other_traversal&)
 
 ALIA_DEFINE_TAGGED_TYPE(by_value_string_tag, std::string)
 
+struct slotted_traversal
+{
+    int value = 0;
+};
+ALIA_DEFINE_TAGGED_TYPE(slotted_traversal_tag, slotted_traversal&)
+ALIA_DEFINE_TAGGED_TYPE(const_slotted_tag, slotted_traversal const&)
+ALIA_ADD_CONTEXT_SLOT(slotted_traversal_tag, 0)
+ALIA_ADD_CONTEXT_SLOT(const_slotted_tag, 1)
+
 TEST_CASE("context_storage", "[context][interface]")
 {
     context_storage storage;
@@ -48,6 +57,31 @@ TEST_CASE("context_storage", "[context][interface]")
     REQUIRE(!storage.has<other_traversal_tag>());
 }
 
+TEST_CASE("slotted context_storage", "[context][interface]")
+{
+    context_storage storage;
+
+    REQUIRE(!storage.has<slotted_traversal_tag>());
+    slotted_traversal slotted;
+    storage.add<slotted_traversal_tag>(slotted);
+    REQUIRE(storage.has<slotted_traversal_tag>());
+    REQUIRE(&storage.get<slotted_traversal_tag>() == &slotted);
+    REQUIRE(storage.slots[0] == &slotted);
+
+    REQUIRE(!storage.has<const_slotted_tag>());
+    slotted_traversal const& const_slotted = slotted;
+    storage.add<const_slotted_tag>(const_slotted);
+    REQUIRE(storage.has<const_slotted_tag>());
+    REQUIRE(&storage.get<const_slotted_tag>() == &slotted);
+    REQUIRE(storage.slots[1] == &slotted);
+
+    storage.remove<slotted_traversal_tag>();
+    REQUIRE(!storage.has<slotted_traversal_tag>());
+    REQUIRE(storage.has<const_slotted_tag>());
+    storage.remove<const_slotted_tag>();
+    REQUIRE(!storage.has<const_slotted_tag>());
+}
+
 TEST_CASE("context", "[context][interface]")
 {
     context_storage storage;
@@ -89,6 +123,15 @@ TEST_CASE("context", "[context][interface]")
         REQUIRE(&get<other_traversal_tag>(with_ctx) == &other);
     });
 
+    slotted_traversal slotted;
+    auto slotted_ctx
+        = extend_context<slotted_traversal_tag>(extended, slotted);
+    REQUIRE(detail::has_context_object<slotted_traversal_tag>(slotted_ctx));
+    REQUIRE(&get<slotted_traversal_tag>(slotted_ctx) == &slotted);
+    REQUIRE(&get<other_traversal_tag>(slotted_ctx) == &other);
+    REQUIRE(!get_structural_collection(extended).storage->template has<
+            slotted_traversal_tag>());
+
     auto more_extended = extend_context<by_value_string_tag>(extended, "test");
     REQUIRE(detail::has_context_object<by_value_string_tag>(more_extended));
     REQUIRE(get<by_value_string_tag>(more_extended) == "test");
@@ -192,3 +235,149 @@ TEST_CASE("content IDs", "[context][interface]")
     REQUIRE(last_outer == outer_id);
     REQUIRE(last_inner == inner_id);
 }
+
+#ifdef NDEBUG
+
+namespace {
+
+struct generic_a
+{
+};
+ALIA_DEFINE_TAGGED_TYPE(generic_a_tag, generic_a&)
+struct generic_b
+{
+};
+ALIA_DEFINE_TAGGED_TYPE(generic_b_tag, generic_b&)
+struct generic_c
+{
+};
+ALIA_DEFINE_TAGGED_TYPE(generic_c_tag, generic_c&)
+
+} // namespace
+
+TEST_CASE("context access benchmarks", "[context][interface]")
+{
+    context_storage storage;
+
+    alia::system sys;
+    data_traversal data;
+    event_traversal event;
+    timing_subsystem timing;
+
+    scoped_data_traversal sdt(sys.data, data);
+
+    context ctx = make_context(&storage, sys, event, data, timing);
+
+    // Give the generic storage a few other objects to search through, like a
+    // typical application would.
+    generic_a a;
+    generic_b b;
+    generic_c c;
+    auto generic_ctx = extend_context<generic_c_tag>(
+        extend_context<generic_b_tag>(
+            extend_context<generic_a_tag>(ctx, a), b),
+        c);
+
+    other_traversal other;
+    slotted_traversal slotted;
+    auto full_ctx = extend_context<slotted_traversal_tag>(
+        extend_context<other_traversal_tag>(generic_ctx, other), slotted);
+
+    BENCHMARK("1000 generic context accesses")
+    {
+        other_traversal* result = nullptr;
+        for (int i = 0; i != 1000; ++i)
+        {
+            result = &get<other_traversal_tag>(full_ctx);
+            Catch::Benchmark::deoptimize_value(result);
+        }
+        return result;
+    };
+
+    BENCHMARK("1000 slotted context accesses")
+    {
+        slotted_traversal* result = nullptr;
+        for (int i = 0; i != 1000; ++i)
+        {
+            result = &get<slotted_traversal_tag>(full_ctx);
+            Catch::Benchmark::deoptimize_value(result);
+        }
+        return result;
+    };
+}
+
+namespace {
+
+template<int N>
+struct chain_object
+{
+    int value = N;
+};
+template<int N>
+struct chain_tag
+{
+    typedef chain_object<N>& data_type;
+};
+
+template<int N>
+chain_object<N>&
+get_chain_object()
+{
+    static chain_object<N> object;
+    return object;
+}
+
+// Extend the context with a chain of :Depth objects and then read from both
+// ends of the chain.
+template<int Depth, int N = 1, class Context>
+int
+extend_context_chain(Context ctx)
+{
+    auto extended = extend_context<chain_tag<N>>(ctx, get_chain_object<N>());
+    if constexpr (N == Depth)
+    {
+        return get<chain_tag<1>>(extended).value
+               + get<chain_tag<Depth>>(extended).value;
+    }
+    else
+    {
+        return extend_context_chain<Depth, N + 1>(extended);
+    }
+}
+
+} // namespace
+
+TEST_CASE("context extension benchmarks", "[context][interface]")
+{
+    alia::system sys;
+    int result = 0;
+
+    initialize_system(
+        sys, [&](context ctx) { result = extend_context_chain<4>(ctx); });
+    refresh_system(sys);
+    REQUIRE(result == 5);
+    BENCHMARK("4-level context extension")
+    {
+        refresh_system(sys);
+    };
+
+    initialize_system(
+        sys, [&](context ctx) { result = extend_context_chain<16>(ctx); });
+    refresh_system(sys);
+    REQUIRE(result == 17);
+    BENCHMARK("16-level context extension")
+    {
+        refresh_system(sys);
+    };
+
+    initialize_system(
+        sys, [&](context ctx) { result = extend_context_chain<32>(ctx); });
+    refresh_system(sys);
+    REQUIRE(result == 33);
+    BENCHMARK("32-level context extension")
+    {
+        refresh_system(sys);
+    };
+}
+
+#endif
@@ -153,6 +153,45 @@ TEST_CASE("tagged data casting", "[context][typing]")
     REQUIRE(get_tagged_data<int_tag>(ctx) == 1);
 }
 
+ALIA_DEFINE_TAGGED_TYPE(other_int_tag, int)
+
+TEST_CASE("linked tagged storage", "[context][typing]")
+{
+    generic_tagged_storage<int> parent;
+    parent.add<int_tag>(1);
+    parent.add<other_int_tag>(2);
+
+    generic_tagged_storage<int> child;
+    child.add<other_int_tag>(7);
+    // Linking clears anything that was already there.
+    child.link_to(&parent);
+    REQUIRE(child.get<other_int_tag>() == 2);
+    REQUIRE(child.has<int_tag>());
+    REQUIRE(child.get<int_tag>() == 1);
+
+    // Objects added to the child shadow the parent's.
+    child.add<int_tag>(3);
+    REQUIRE(child.get<int_tag>() == 3);
+    REQUIRE(parent.get<int_tag>() == 1);
+
+    // Removing an object from the child hides the parent's.
+    child.remove<other_int_tag>();
+    REQUIRE(!child.has<other_int_tag>());
+    REQUIRE(parent.has<other_int_tag>());
+    REQUIRE_THROWS(child.get<other_int_tag>());
+    child.add<other_int_tag>(4);
+    REQUIRE(child.get<other_int_tag>() == 4);
+
+    // Links can be chained.
+    generic_tagged_storage<int> grandchild;
+    grandchild.link_to(&child);
+    REQUIRE(grandchild.get<int_tag>() == 3);
+    REQUIRE(grandchild.get<other_int_tag>() == 4);
+    grandchild.remove<int_tag>();
+    REQUIRE(!grandchild.has<int_tag>());
+    REQUIRE(child.has<int_tag>());
+}
+
 namespace {
 
 using std::string;
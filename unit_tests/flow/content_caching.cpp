@@ -272,3 +272,227 @@ TEST_CASE("exceptional content caching", "[flow][content_caching]")
     check_log("removing bit0; relocating bit4 into root after bit2; ");
     REQUIRE(root.object.to_string() == "root(bit2();bit4();)");
 }
+
+namespace {
+
+// a content value that doesn't provide a hash (so all of its values have the
+// same fingerprint)
+struct unhashed_content
+{
+    int value;
+};
+bool
+operator==(unhashed_content const& a, unhashed_content const& b)
+{
+    return a.value == b.value;
+}
+bool
+operator<(unhashed_content const& a, unhashed_content const& b)
+{
+    return a.value < b.value;
+}
+
+// a content value whose hash is (deliberately) terrible, so all of its
+// values collide
+struct colliding_content
+{
+    int value;
+};
+bool
+operator==(colliding_content const& a, colliding_content const& b)
+{
+    return a.value == b.value;
+}
+bool
+operator<(colliding_content const& a, colliding_content const& b)
+{
+    return a.value < b.value;
+}
+
+int counted_content_comparisons = 0;
+
+struct counted_content
+{
+    int value;
+};
+bool
+operator==(counted_content const& a, counted_content const& b)
+{
+    ++counted_content_comparisons;
+    return a.value == b.value;
+}
+bool
+operator<(counted_content const& a, counted_content const& b)
+{
+    return a.value < b.value;
+}
+
+} // namespace
+
+namespace std {
+template<>
+struct hash<colliding_content>
+{
+    size_t
+    operator()(colliding_content const&) const
+    {
+        return 17;
+    }
+};
+template<>
+struct hash<counted_content>
+{
+    size_t
+    operator()(counted_content const& x) const
+    {
+        return hash<int>()(x.value);
+    }
+};
+} // namespace std
+
+TEST_CASE("content fingerprints", "[flow][content_caching]")
+{
+    int n = 0;
+    int hashed_traversals = 0, unhashed_traversals = 0,
+        colliding_traversals = 0;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        invoke_pure_component(
+            ctx, [&](auto, auto) { ++hashed_traversals; }, value(n));
+        invoke_pure_component(
+            ctx,
+            [&](auto, auto) { ++unhashed_traversals; },
+            value(unhashed_content{n}));
+        invoke_pure_component(
+            ctx,
+            [&](auto, auto) { ++colliding_traversals; },
+            value(colliding_content{n}));
+    });
+
+    auto check_traversals = [&](int hashed, int unhashed, int colliding) {
+        REQUIRE(hashed_traversals == hashed);
+        REQUIRE(unhashed_traversals == unhashed);
+        REQUIRE(colliding_traversals == colliding);
+    };
+
+    refresh_system(sys);
+    check_traversals(1, 1, 1);
+
+    refresh_system(sys);
+    check_traversals(1, 1, 1);
+
+    // By default, content IDs are compared in full, so changes are detected
+    // even when the fingerprints collide.
+    n = 1;
+    refresh_system(sys);
+    check_traversals(2, 2, 2);
+
+    // When fingerprints are trusted, a collision hides the change...
+    sys.trust_content_fingerprints = true;
+    n = 2;
+    refresh_system(sys);
+    check_traversals(3, 3, 2);
+    refresh_system(sys);
+    check_traversals(3, 3, 2);
+
+    // (but IDs without meaningful hashes are still compared in full)
+    n = 3;
+    refresh_system(sys);
+    check_traversals(4, 4, 2);
+
+    // until the full comparison is reenabled.
+    sys.trust_content_fingerprints = false;
+    refresh_system(sys);
+    check_traversals(4, 4, 3);
+}
+
+TEST_CASE("content fingerprint rejection", "[flow][content_caching]")
+{
+    int n = 0;
+    int traversals = 0;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        invoke_pure_component(
+            ctx, [&](auto, auto) { ++traversals; }, value(counted_content{n}));
+    });
+
+    refresh_system(sys);
+    REQUIRE(traversals == 1);
+
+    // When the content hasn't changed, the fingerprints match, so the IDs are
+    // compared in full.
+    counted_content_comparisons = 0;
+    refresh_system(sys);
+    REQUIRE(traversals == 1);
+    REQUIRE(counted_content_comparisons == 1);
+
+    // When it has changed, the mismatched fingerprints are enough to detect
+    // that.
+    counted_content_comparisons = 0;
+    n = 1;
+    refresh_system(sys);
+    REQUIRE(traversals == 2);
+    REQUIRE(counted_content_comparisons == 0);
+
+    // And when fingerprints are trusted, the IDs are never compared in full.
+    sys.trust_content_fingerprints = true;
+    counted_content_comparisons = 0;
+    refresh_system(sys);
+    REQUIRE(traversals == 2);
+    n = 2;
+    refresh_system(sys);
+    REQUIRE(traversals == 3);
+    REQUIRE(counted_content_comparisons == 0);
+}
+
+TEST_CASE("ID hash meaningfulness", "[flow][content_caching]")
+{
+    REQUIRE(make_id(1).hash_is_meaningful());
+    REQUIRE(!make_id(unhashed_content{1}).hash_is_meaningful());
+    REQUIRE(make_id(colliding_content{1}).hash_is_meaningful());
+    REQUIRE(combine_ids(make_id(1), make_id(2)).hash_is_meaningful());
+    auto unhashed = make_id(unhashed_content{1});
+    REQUIRE(!combine_ids(make_id(1), ref(unhashed)).hash_is_meaningful());
+}
+
+#ifdef NDEBUG
+TEST_CASE("content caching benchmarks", "[flow][content_caching]")
+{
+    // Refresh 10,000 cached components whose content hasn't changed, so every
+    // refresh is dominated by the content ID checks.
+    int const component_count = 10000;
+    std::vector<std::string> labels;
+    for (int i = 0; i != component_count; ++i)
+        labels.push_back("component label #" + std::to_string(i));
+
+    int traversals = 0;
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        for (int i = 0; i != component_count; ++i)
+        {
+            invoke_pure_component(
+                ctx,
+                [&](auto, auto, auto) { ++traversals; },
+                value(i),
+                direct(labels[size_t(i)]));
+        }
+    });
+    refresh_system(sys);
+    REQUIRE(traversals == component_count);
+
+    BENCHMARK("10k cached components")
+    {
+        refresh_system(sys);
+    };
+
+    sys.trust_content_fingerprints = true;
+    BENCHMARK("10k cached components (trusted fingerprints)")
+    {
+        refresh_system(sys);
+    };
+
+    REQUIRE(traversals == component_count);
+}
+#endif
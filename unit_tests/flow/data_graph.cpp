@@ -347,6 +347,156 @@ TEST_CASE("manual deletion", "[data_graph]")
         "destructing int: 1;");
 }
 
+namespace {
+
+// an ID value type that doesn't support std::hash (so all of its IDs collide)
+struct unhashable_index
+{
+    int value;
+};
+bool
+operator==(unhashable_index a, unhashable_index b)
+{
+    return a.value == b.value;
+}
+bool
+operator<(unhashable_index a, unhashable_index b)
+{
+    return a.value < b.value;
+}
+
+template<class MakeId>
+void
+test_large_naming_context(MakeId make_index_id)
+{
+    data_graph graph;
+    int initializations = 0;
+    auto make_controller = [&](std::vector<int> indices) {
+        return [=, &initializations](context ctx) {
+            naming_context nc(ctx);
+            for (auto i : indices)
+            {
+                // Blocks for multiples of 7 require manual deletion.
+                named_block nb(
+                    nc, make_index_id(i), manual_delete(i % 7 == 0));
+                int* value;
+                if (get_data(ctx, &value))
+                {
+                    *value = i;
+                    ++initializations;
+                }
+                REQUIRE(*value == i);
+            }
+        };
+    };
+    auto range = [](int begin, int end, int step = 1) {
+        std::vector<int> indices;
+        for (int i = begin; i != end; i += step)
+            indices.push_back(i);
+        return indices;
+    };
+
+    // Build up enough blocks to require a proper table.
+    do_traversal(graph, make_controller(range(0, 500)));
+    REQUIRE(initializations == 500);
+    // Reverse the order. Nothing should be recreated.
+    do_traversal(graph, make_controller(range(499, -1, -1)));
+    REQUIRE(initializations == 500);
+    // Drop all the odd blocks and bring them back.
+    do_traversal(graph, make_controller(range(0, 500, 2)));
+    do_traversal(graph, make_controller(range(0, 500)));
+    // The odd multiples of 7 should have survived.
+    REQUIRE(initializations == 500 + 250 - 36);
+    initializations = 0;
+    // Shrink down to a few blocks (which should send the table back to
+    // inline mode) and then grow again.
+    do_traversal(graph, make_controller({1, 2, 3}));
+    do_traversal(graph, make_controller(range(0, 100)));
+    REQUIRE(initializations == 100 - 3 - 15);
+    initializations = 0;
+    // Manually delete one of the inactive manual blocks.
+    do_traversal(graph, make_controller({1, 2, 3}));
+    delete_named_block(graph, make_index_id(49));
+    do_traversal(graph, make_controller(range(0, 100)));
+    REQUIRE(initializations == 100 - 3 - 14);
+}
+
+} // namespace
+
+TEST_CASE("large naming contexts", "[data_graph]")
+{
+    test_large_naming_context([](int i) { return make_id(i); });
+    test_large_naming_context(
+        [](int i) { return combine_ids(make_id(i), make_id("name")); });
+    test_large_naming_context(
+        [](int i) { return make_id(unhashable_index{i}); });
+}
+
+#ifdef NDEBUG
+TEST_CASE("named block lookup benchmarks", "[data_graph]")
+{
+    auto make_controller = [](std::vector<int> const& indices) {
+        return [&](context ctx) {
+            naming_context nc(ctx);
+            for (auto i : indices)
+            {
+                named_block nb(nc, make_id(i));
+                get_data<int>(ctx);
+            }
+        };
+    };
+
+    for (int n : {100, 1000, 10000, 100000, 1000000})
+    {
+        std::vector<int> forward, reversed, none;
+        for (int i = 0; i != n; ++i)
+        {
+            forward.push_back(i);
+            reversed.push_back(n - 1 - i);
+        }
+        std::string const suffix = " (" + std::to_string(n) + ")";
+
+        {
+            data_graph graph;
+            do_traversal(graph, make_controller(forward));
+            bool flip = false;
+            BENCHMARK("named block reorder" + suffix)
+            {
+                flip = !flip;
+                do_traversal(
+                    graph, make_controller(flip ? reversed : forward));
+            };
+        }
+
+        BENCHMARK("named block insertion" + suffix)
+        {
+            data_graph graph;
+            do_traversal(graph, make_controller(forward));
+        };
+
+        // The deletion benchmark needs a fully populated graph for every run
+        // (since Catch times all runs in one go), so its memory use scales
+        // with the run count. It's capped accordingly.
+        if (n > 100000)
+            continue;
+
+        BENCHMARK_ADVANCED("named block deletion" + suffix)
+        (Catch::Benchmark::Chronometer meter)
+        {
+            std::vector<std::unique_ptr<data_graph>> graphs(meter.runs());
+            for (auto& graph : graphs)
+            {
+                graph.reset(new data_graph);
+                do_traversal(*graph, make_controller(forward));
+            }
+            meter.measure([&](int i) {
+                do_traversal(*graphs[i], make_controller(none));
+            });
+        };
+    }
+}
+#endif
+
 TEST_CASE("named block caching", "[data_graph]")
 {
     clear_log();
@@ -530,3 +680,239 @@ TEST_CASE("data node destruction order", "[data_graph]")
         "destructing int: 2;"
         "destructing int: 1;");
 }
+
+TEST_CASE("pooled data node allocation", "[data_graph]")
+{
+    pooled_data_node_allocator pool;
+    REQUIRE(pool.reserved_bytes() == 0);
+
+    // Nodes of the same size class should be recycled.
+    void* a = pool.allocate(24);
+    void* b = pool.allocate(24);
+    REQUIRE(a != b);
+    REQUIRE(pool.reserved_bytes() != 0);
+    pool.deallocate(a, 24);
+    REQUIRE(pool.allocate(20) == a);
+
+    // Nodes of different size classes shouldn't be.
+    pool.deallocate(b, 24);
+    void* c = pool.allocate(40);
+    REQUIRE(c != b);
+    pool.deallocate(c, 40);
+
+    // Oversized nodes go straight to the heap.
+    std::size_t reserved = pool.reserved_bytes();
+    void* big = pool.allocate(4096);
+    REQUIRE(pool.reserved_bytes() == reserved);
+    pool.deallocate(big, 4096);
+}
+
+namespace {
+
+struct counting_data_node_allocator : data_node_allocator
+{
+    void*
+    allocate(std::size_t size) override
+    {
+        ++live_nodes;
+        return ::operator new(size);
+    }
+
+    void
+    deallocate(void* storage, std::size_t) noexcept override
+    {
+        --live_nodes;
+        ::operator delete(storage);
+    }
+
+    int live_nodes = 0;
+};
+
+} // namespace
+
+TEST_CASE("custom data node allocators", "[data_graph]")
+{
+    clear_log();
+    counting_data_node_allocator allocator;
+    {
+        data_graph graph;
+        graph.allocator = &allocator;
+        auto make_controller = [](std::vector<int> indices) {
+            return [=](context ctx) {
+                naming_context nc(ctx);
+                for (auto i : indices)
+                {
+                    named_block nb(nc, make_id(i));
+                    do_int(ctx, i);
+                }
+            };
+        };
+        do_traversal(graph, make_controller({1, 2}));
+        check_log(
+            "initializing int: 1;"
+            "initializing int: 2;");
+        int initial_nodes = allocator.live_nodes;
+        REQUIRE(initial_nodes > 2);
+        do_traversal(graph, make_controller({2}));
+        check_log(
+            "visiting int: 2;"
+            "destructing int: 1;");
+        // Both the named block and the int inside it should be released.
+        REQUIRE(allocator.live_nodes == initial_nodes - 2);
+    }
+    check_log("destructing int: 2;");
+    REQUIRE(allocator.live_nodes == 0);
+}
+
+TEST_CASE("heap-allocated data nodes", "[data_graph]")
+{
+    clear_log();
+    {
+        data_graph graph;
+        graph.allocator = &get_heap_data_node_allocator();
+        auto controller = [](context ctx) {
+            do_int(ctx, 0);
+            ALIA_IF(true)
+            {
+                do_int(ctx, 1);
+            }
+            ALIA_END
+        };
+        do_traversal(graph, controller);
+        check_log(
+            "initializing int: 0;"
+            "initializing int: 1;");
+        do_traversal(graph, controller);
+        check_log(
+            "visiting int: 0;"
+            "visiting int: 1;");
+        REQUIRE(graph.pool.reserved_bytes() == 0);
+    }
+    check_log(
+        "destructing int: 1;"
+        "destructing int: 0;");
+}
+
+#ifdef NDEBUG
+TEST_CASE("data node allocation benchmarks", "[data_graph]")
+{
+    // Build up a graph with a bunch of named blocks, then alternate between
+    // two disjoint sets of names so that every pass garbage collects the
+    // blocks from the previous one and builds new ones in their place.
+    auto make_controller = [](int offset) {
+        return [=](context ctx) {
+            naming_context nc(ctx);
+            for (int i = 0; i != 100; ++i)
+            {
+                named_block nb(nc, make_id(offset + i));
+                get_data<int>(ctx);
+                get_data<double>(ctx);
+                ALIA_IF(true)
+                {
+                    get_data<int>(ctx);
+                }
+                ALIA_END
+            }
+        };
+    };
+    auto run_benchmark
+        = [&](data_graph& graph, data_node_allocator* allocator) {
+              if (allocator)
+                  graph.allocator = allocator;
+              for (int i = 0; i != 10; ++i)
+                  do_traversal(graph, make_controller((i % 2) * 100));
+          };
+
+    BENCHMARK("pooled graph churn")
+    {
+        data_graph graph;
+        run_benchmark(graph, nullptr);
+    };
+    BENCHMARK("heap graph churn")
+    {
+        data_graph graph;
+        run_benchmark(graph, &get_heap_data_node_allocator());
+    };
+}
+#endif
+
+TEST_CASE("huge data blocks", "[data_graph]")
+{
+    // These would overflow the stack if destruction or cache clearing were
+    // recursive over the nodes in a block (or over the nested blocks that
+    // loops create).
+    int const node_count = 1000000;
+
+    int live_objects = 0;
+    struct counted_object
+    {
+        int* counter = nullptr;
+        ~counted_object()
+        {
+            if (counter)
+                --*counter;
+        }
+    };
+    auto do_object = [&](counted_object* object) {
+        if (!object->counter)
+        {
+            object->counter = &live_objects;
+            ++live_objects;
+        }
+    };
+
+    SECTION("flat")
+    {
+        data_graph graph;
+        auto make_controller = [&](bool active) {
+            return [=](context ctx) {
+                ALIA_IF(active)
+                {
+                    for (int i = 0; i != node_count; ++i)
+                    {
+                        counted_object* object;
+                        get_cached_data(ctx, &object);
+                        do_object(object);
+                    }
+                }
+                ALIA_END
+            };
+        };
+        do_traversal(graph, make_controller(true));
+        REQUIRE(live_objects == node_count);
+        // Deactivating the block clears the cached objects.
+        do_traversal(graph, make_controller(false));
+        REQUIRE(live_objects == 0);
+        do_traversal(graph, make_controller(true));
+        REQUIRE(live_objects == node_count);
+    }
+
+    SECTION("looped")
+    {
+        data_graph graph;
+        auto make_controller = [&](bool active) {
+            return [=](context ctx) {
+                ALIA_IF(active)
+                {
+                    ALIA_FOR(int i = 0; i != node_count; ++i)
+                    {
+                        counted_object* object;
+                        get_cached_data(ctx, &object);
+                        do_object(object);
+                    }
+                    ALIA_END
+                }
+                ALIA_END
+            };
+        };
+        do_traversal(graph, make_controller(true));
+        REQUIRE(live_objects == node_count);
+        do_traversal(graph, make_controller(false));
+        REQUIRE(live_objects == 0);
+        do_traversal(graph, make_controller(true));
+        REQUIRE(live_objects == node_count);
+    }
+
+    // Dropping the graph destroys everything.
+    REQUIRE(live_objects == 0);
+}
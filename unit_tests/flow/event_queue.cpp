@@ -0,0 +1,177 @@
+#include <alia/flow/event_queue.hpp>
+
+#include <testing.hpp>
+
+#include <alia/system/internals.hpp>
+
+using namespace alia;
+using std::string;
+
+namespace {
+
+struct move_event : targeted_event
+{
+    int x;
+};
+
+struct click_event : targeted_event
+{
+};
+
+struct broadcast_event
+{
+    int n;
+};
+
+} // namespace
+
+TEST_CASE("event queue", "[flow][event_queue]")
+{
+    std::vector<external_component_id> ids;
+    string log;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        ids.clear();
+        for (int i = 0; i != 2; ++i)
+        {
+            auto id = get_component_id(ctx);
+            ids.push_back(externalize(id));
+            targeted_event_handler<move_event>(
+                ctx, id, [&, i](auto, move_event& e) {
+                    log += "move" + std::to_string(i) + ":"
+                           + std::to_string(e.x) + ";";
+                });
+            targeted_event_handler<click_event>(
+                ctx, id, [&, i](auto, click_event&) {
+                    log += "click" + std::to_string(i) + ";";
+                });
+        }
+        event_handler<broadcast_event>(ctx, [&](auto, broadcast_event& e) {
+            log += "broadcast:" + std::to_string(e.n) + ";";
+        });
+    });
+    refresh_system(sys);
+
+    set_event_coalescing<move_event>(sys, event_coalescing::keep_latest);
+    set_event_coalescing<broadcast_event>(sys, event_coalescing::keep_latest);
+
+    auto queue_move = [&](int target, int x) {
+        move_event e;
+        e.x = x;
+        queue_targeted_event(sys, e, ids[target]);
+    };
+
+    queue_move(0, 1);
+    queue_move(1, 1);
+    queue_move(0, 2);
+    queue_targeted_event(sys, click_event(), ids[0]);
+    queue_targeted_event(sys, click_event(), ids[0]);
+    queue_move(0, 3);
+    queue_event(sys, broadcast_event{1});
+    queue_event(sys, broadcast_event{2});
+    REQUIRE(has_queued_events(sys.queued_events));
+
+    auto refreshes_before = sys.refresh_counter;
+    process_event_batch(sys);
+    REQUIRE(log == "move1:1;click0;click0;move0:3;broadcast:2;");
+    REQUIRE(sys.refresh_counter == refreshes_before + 1);
+    REQUIRE(!has_queued_events(sys.queued_events));
+
+    auto const& metrics = get_event_queue_metrics(sys);
+    REQUIRE(metrics.queued == 8);
+    REQUIRE(metrics.coalesced == 3);
+    REQUIRE(metrics.delivered == 5);
+    REQUIRE(metrics.batches == 1);
+    REQUIRE(metrics.peak_size == 5);
+
+    // An empty batch doesn't even refresh the system.
+    process_event_batch(sys);
+    REQUIRE(sys.refresh_counter == refreshes_before + 1);
+    REQUIRE(metrics.batches == 1);
+
+    // Once coalescing is turned off, all events are delivered.
+    set_event_coalescing<move_event>(sys, event_coalescing::none);
+    log.clear();
+    queue_move(1, 4);
+    queue_move(1, 5);
+    process_event_batch(sys);
+    REQUIRE(log == "move1:4;move1:5;");
+    REQUIRE(metrics.batches == 2);
+}
+
+TEST_CASE("events queued within a batch", "[flow][event_queue]")
+{
+    string log;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        event_handler<broadcast_event>(ctx, [&](auto, broadcast_event& e) {
+            log += std::to_string(e.n) + ";";
+            if (e.n < 3)
+                queue_event(sys, broadcast_event{e.n + 1});
+        });
+    });
+    refresh_system(sys);
+
+    // Coalescing an event that's already been delivered has no effect on
+    // it.
+    set_event_coalescing<broadcast_event>(sys, event_coalescing::keep_latest);
+
+    auto refreshes_before = sys.refresh_counter;
+    queue_event(sys, broadcast_event{0});
+    process_event_batch(sys);
+    REQUIRE(log == "0;1;2;3;");
+    REQUIRE(sys.refresh_counter == refreshes_before + 1);
+    REQUIRE(get_event_queue_metrics(sys).coalesced == 0);
+}
+
+#ifdef NDEBUG
+
+TEST_CASE("event batching benchmarks", "[flow][event_queue]")
+{
+    int const component_count = 1000;
+    int const burst_size = 200;
+
+    std::vector<external_component_id> ids;
+    int position = 0;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        ids.clear();
+        for (int i = 0; i != component_count; ++i)
+        {
+            auto id = get_component_id(ctx);
+            ids.push_back(externalize(id));
+            targeted_event_handler<move_event>(
+                ctx, id, [&](auto, move_event& e) { position = e.x; });
+        }
+    });
+    refresh_system(sys);
+    set_event_coalescing<move_event>(sys, event_coalescing::keep_latest);
+
+    BENCHMARK("dispatching 200 pointer moves individually")
+    {
+        for (int i = 0; i != burst_size; ++i)
+        {
+            move_event e;
+            e.x = i;
+            dispatch_targeted_event(sys, e, ids[component_count / 2]);
+        }
+    };
+
+    BENCHMARK("queuing 200 pointer moves as a batch")
+    {
+        for (int i = 0; i != burst_size; ++i)
+        {
+            move_event e;
+            e.x = i;
+            queue_targeted_event(sys, e, ids[component_count / 2]);
+        }
+        process_event_batch(sys);
+    };
+
+    REQUIRE(position == burst_size - 1);
+}
+
+#endif
@@ -4,6 +4,8 @@
 
 #include <testing.hpp>
 
+#include <alia/flow/content_caching.hpp>
+#include <alia/flow/for_each.hpp>
 #include <alia/signals/basic.hpp>
 #include <alia/signals/lambdas.hpp>
 #include <alia/signals/operators.hpp>
@@ -77,6 +79,165 @@ TEST_CASE("node IDs", "[flow][events]")
     }
 }
 
+TEST_CASE("direct targeted events", "[flow][events]")
+{
+    bool active = true;
+    int event_traversals = 0;
+    std::vector<external_component_id> ids;
+    int received[2] = {0, 0};
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        if (!is_refresh_event(ctx))
+            ++event_traversals;
+        ids.clear();
+        ALIA_IF(active)
+        {
+            // This one has a direct handler.
+            auto direct_id = get_component_id(ctx);
+            ids.push_back(externalize(direct_id));
+            int* counter = &received[0];
+            direct_targeted_event_handler<my_event>(
+                ctx, direct_id, [counter](my_event& e) {
+                    ++*counter;
+                    e.result = "direct";
+                });
+        }
+        ALIA_END
+        // This one needs the full traversal.
+        auto routed_id = get_component_id(ctx);
+        ids.push_back(externalize(routed_id));
+        targeted_event_handler<my_event>(
+            ctx, routed_id, [&](auto, my_event& e) {
+                ++received[1];
+                e.result = "routed";
+            });
+    });
+    refresh_system(sys);
+    auto direct_id = ids[0];
+    auto routed_id = ids[1];
+
+    {
+        my_event event;
+        dispatch_targeted_event(sys, event, direct_id);
+        REQUIRE(event.result == "direct");
+        REQUIRE(received[0] == 1);
+        REQUIRE(event_traversals == 0);
+    }
+    {
+        my_event event;
+        dispatch_targeted_event(sys, event, routed_id);
+        REQUIRE(event.result == "routed");
+        REQUIRE(received[1] == 1);
+        REQUIRE(event_traversals == 1);
+    }
+
+    // Once the component is gone, its handler is too.
+    active = false;
+    refresh_system(sys);
+    REQUIRE(sys.direct_event_handlers.empty());
+    {
+        my_event event;
+        dispatch_targeted_event(sys, event, direct_id);
+        REQUIRE(event.result == "");
+        REQUIRE(received[0] == 1);
+    }
+}
+
+namespace {
+
+struct stop_event
+{
+    string stop_at;
+    string visited;
+};
+
+static void
+do_stoppable_thing(context ctx, int& initializations, string const& label)
+{
+    int* data;
+    if (get_data(ctx, &data))
+        ++initializations;
+
+    event_handler<stop_event>(ctx, [&](auto ctx, stop_event& e) {
+        e.visited += label + ";";
+        if (e.stop_at == label)
+            abort_traversal(ctx);
+    });
+}
+
+} // namespace
+
+TEST_CASE("exception-free traversal abortion", "[flow][events]")
+{
+    for (bool exception_free : {false, true})
+    {
+        int initializations = 0;
+        std::vector<string> items = {"each0", "each1"};
+
+        alia::system sys;
+        initialize_system(sys, [&](context ctx) {
+            ALIA_IF(true)
+            {
+                do_stoppable_thing(ctx, initializations, "if");
+            }
+            ALIA_END
+            ALIA_FOR(int i = 0; i != 3; ++i)
+            {
+                do_stoppable_thing(
+                    ctx, initializations, "for" + std::to_string(i));
+            }
+            ALIA_END
+            for_each(ctx, items, [&](string const& item) {
+                do_stoppable_thing(ctx, initializations, item);
+            });
+            invoke_pure_component(ctx, [&](context ctx) {
+                do_stoppable_thing(ctx, initializations, "pure");
+            });
+            {
+                scoped_component_container container(ctx);
+                ALIA_IF(container.is_on_route())
+                {
+                    do_stoppable_thing(ctx, initializations, "scoped");
+                }
+                ALIA_END
+            }
+            ALIA_IF(false)
+            {
+            }
+            ALIA_ELSE
+            {
+                do_stoppable_thing(ctx, initializations, "else");
+            }
+            ALIA_END
+            do_stoppable_thing(ctx, initializations, "last");
+        });
+        sys.exception_free_abortion = exception_free;
+        refresh_system(sys);
+        REQUIRE(initializations == 10);
+
+        auto check_stop = [&](string const& stop_at, string const& expected) {
+            stop_event event;
+            event.stop_at = stop_at;
+            dispatch_event(sys, event);
+            REQUIRE(event.visited == expected);
+        };
+        check_stop("if", "if;");
+        check_stop("for1", "if;for0;for1;");
+        check_stop("each0", "if;for0;for1;for2;each0;");
+        check_stop("pure", "if;for0;for1;for2;each0;each1;pure;");
+        check_stop("scoped", "if;for0;for1;for2;each0;each1;pure;scoped;");
+        check_stop(
+            "else", "if;for0;for1;for2;each0;each1;pure;scoped;else;");
+        check_stop(
+            "none", "if;for0;for1;for2;each0;each1;pure;scoped;else;last;");
+
+        // None of the skipped content should have lost its data.
+        refresh_system(sys);
+        REQUIRE(initializations == 10);
+    }
+}
+
 namespace {
 
 struct bad_event
@@ -363,3 +524,113 @@ TEST_CASE("error isolation", "[flow][events]")
     refresh_system(sys);
     REQUIRE(error_count == 2);
 }
+
+#ifdef NDEBUG
+
+TEST_CASE("targeted event benchmarks", "[flow][events]")
+{
+    int const component_count = 10000;
+
+    bool use_direct_handlers = false;
+    std::vector<external_component_id> ids;
+    int received = 0;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        ids.clear();
+        for (int i = 0; i != component_count; ++i)
+        {
+            auto id = get_component_id(ctx);
+            ids.push_back(externalize(id));
+            ALIA_IF(use_direct_handlers)
+            {
+                int* counter = &received;
+                direct_targeted_event_handler<my_event>(
+                    ctx, id, [counter](my_event&) { ++*counter; });
+            }
+            ALIA_ELSE
+            {
+                targeted_event_handler<my_event>(
+                    ctx, id, [&](auto, my_event&) { ++received; });
+            }
+            ALIA_END
+        }
+    });
+    // Since the handlers don't change any state, the refreshes that follow
+    // the events are no-ops.
+    sys.incremental_refresh = true;
+
+    refresh_system(sys);
+    int n = 0;
+    BENCHMARK("routed targeted events (10k components)")
+    {
+        my_event event;
+        dispatch_targeted_event(
+            sys, event, ids[size_t(n++) * 7919 % component_count]);
+    };
+
+    use_direct_handlers = true;
+    request_full_refresh(sys);
+    refresh_system(sys);
+    BENCHMARK("direct targeted events (10k components)")
+    {
+        my_event event;
+        dispatch_targeted_event(
+            sys, event, ids[size_t(n++) * 7919 % component_count]);
+    };
+
+    REQUIRE(received > 0);
+}
+
+TEST_CASE("traversal abortion benchmarks", "[flow][events]")
+{
+    int const group_count = 100;
+    int const group_size = 100;
+
+    std::vector<external_component_id> ids;
+    int received = 0;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        ids.clear();
+        for (int i = 0; i != group_count; ++i)
+        {
+            scoped_component_container container(ctx);
+            ALIA_IF(container.is_on_route())
+            {
+                for (int j = 0; j != group_size; ++j)
+                {
+                    auto id = get_component_id(ctx);
+                    ids.push_back(externalize(id));
+                    targeted_event_handler<my_event>(
+                        ctx, id, [&](auto, my_event&) { ++received; });
+                }
+            }
+            ALIA_END
+        }
+    });
+    // Since the handlers don't change any state, the refreshes that follow
+    // the events are no-ops.
+    sys.incremental_refresh = true;
+    refresh_system(sys);
+
+    int n = 0;
+    BENCHMARK("targeted events with exception-based abortion (10k components)")
+    {
+        my_event event;
+        dispatch_targeted_event(
+            sys, event, ids[size_t(n++) * 7919 % ids.size()]);
+    };
+
+    sys.exception_free_abortion = true;
+    BENCHMARK("targeted events with exception-free abortion (10k components)")
+    {
+        my_event event;
+        dispatch_targeted_event(
+            sys, event, ids[size_t(n++) * 7919 % ids.size()]);
+    };
+
+    REQUIRE(received > 0);
+}
+
+#endif
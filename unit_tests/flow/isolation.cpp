@@ -0,0 +1,274 @@
+#include <alia/flow/isolation.hpp>
+
+#include <alia/flow/macros.hpp>
+#include <alia/signals/basic.hpp>
+#include <alia/signals/state.hpp>
+
+#include <flow/testing.hpp>
+
+#include <optional>
+
+namespace {
+
+struct isolation_test_state
+{
+    int controller_runs = 0;
+    int content_runs[3] = {0, 0, 0};
+    state_signal<int> states[3] = {
+        state_signal<int>(nullptr),
+        state_signal<int>(nullptr),
+        state_signal<int>(nullptr)};
+    state_signal<int> outer_state = state_signal<int>(nullptr);
+    int last_values[3] = {0, 0, 0};
+};
+
+void
+isolation_test_controller(context ctx, isolation_test_state& test)
+{
+    ++test.controller_runs;
+    test.outer_state = get_state(ctx, 0);
+    for (int i = 0; i != 3; ++i)
+    {
+        invoke_isolated_component(ctx, [&test, i](context ctx) {
+            ++test.content_runs[i];
+            auto state = get_state(ctx, i * 10);
+            test.states[i] = state;
+            test.last_values[i] = read_signal(state);
+        });
+    }
+}
+
+} // namespace
+
+TEST_CASE("full refreshes of isolated components", "[flow][isolation]")
+{
+    isolation_test_state test;
+    alia::system sys;
+    initialize_system(
+        sys, [&](context ctx) { isolation_test_controller(ctx, test); });
+
+    refresh_system(sys);
+    REQUIRE(test.controller_runs == 1);
+    REQUIRE(test.content_runs[1] == 1);
+    REQUIRE(test.last_values[1] == 10);
+
+    // Without incremental refreshes, everything runs every time.
+    write_signal(test.states[1], 11);
+    refresh_system(sys);
+    REQUIRE(test.controller_runs == 2);
+    REQUIRE(test.content_runs[0] == 2);
+    REQUIRE(test.content_runs[1] == 2);
+    REQUIRE(test.last_values[1] == 11);
+}
+
+TEST_CASE("incremental refreshes", "[flow][isolation]")
+{
+    isolation_test_state test;
+    alia::system sys;
+    sys.incremental_refresh = true;
+    initialize_system(
+        sys, [&](context ctx) { isolation_test_controller(ctx, test); });
+
+    // The first refresh always runs the whole controller.
+    refresh_system(sys);
+    REQUIRE(test.controller_runs == 1);
+    REQUIRE(test.content_runs[0] == 1);
+    REQUIRE(test.content_runs[1] == 1);
+    REQUIRE(test.content_runs[2] == 1);
+
+    // If nothing has changed, nothing runs.
+    refresh_system(sys);
+    REQUIRE(test.controller_runs == 1);
+    REQUIRE(test.content_runs[1] == 1);
+
+    // A change within an isolated component only re-enters that component.
+    write_signal(test.states[1], 11);
+    REQUIRE(sys.root_component->dirty);
+    refresh_system(sys);
+    REQUIRE(!sys.root_component->dirty);
+    REQUIRE(test.controller_runs == 1);
+    REQUIRE(test.content_runs[0] == 1);
+    REQUIRE(test.content_runs[1] == 2);
+    REQUIRE(test.content_runs[2] == 1);
+    REQUIRE(test.last_values[1] == 11);
+
+    // Multiple components can be re-entered in one refresh.
+    write_signal(test.states[0], 1);
+    write_signal(test.states[2], 21);
+    refresh_system(sys);
+    REQUIRE(test.controller_runs == 1);
+    REQUIRE(test.content_runs[0] == 2);
+    REQUIRE(test.content_runs[1] == 2);
+    REQUIRE(test.content_runs[2] == 2);
+    REQUIRE(test.last_values[0] == 1);
+    REQUIRE(test.last_values[2] == 21);
+
+    // The re-entered components kept their data.
+    refresh_system(sys);
+    write_signal(test.states[1], 12);
+    refresh_system(sys);
+    REQUIRE(test.last_values[0] == 1);
+    REQUIRE(test.last_values[1] == 12);
+    REQUIRE(test.last_values[2] == 21);
+
+    // A change outside of any isolated component requires a full refresh.
+    write_signal(test.outer_state, 1);
+    refresh_system(sys);
+    REQUIRE(test.controller_runs == 2);
+    REQUIRE(test.content_runs[0] == 3);
+
+    // And a full refresh can also be explicitly requested.
+    request_full_refresh(sys);
+    refresh_system(sys);
+    REQUIRE(test.controller_runs == 3);
+    refresh_system(sys);
+    REQUIRE(test.controller_runs == 3);
+}
+
+TEST_CASE("nested isolated components", "[flow][isolation]")
+{
+    int outer_runs = 0, inner_runs = 0;
+    state_signal<int> outer_state(nullptr), inner_state(nullptr);
+
+    alia::system sys;
+    sys.incremental_refresh = true;
+    initialize_system(sys, [&](context ctx) {
+        invoke_isolated_component(ctx, [&](context ctx) {
+            ++outer_runs;
+            outer_state = get_state(ctx, 0);
+            invoke_isolated_component(ctx, [&](context ctx) {
+                ++inner_runs;
+                inner_state = get_state(ctx, 0);
+            });
+        });
+    });
+
+    refresh_system(sys);
+    REQUIRE(outer_runs == 1);
+    REQUIRE(inner_runs == 1);
+
+    write_signal(inner_state, 1);
+    refresh_system(sys);
+    REQUIRE(outer_runs == 1);
+    REQUIRE(inner_runs == 2);
+
+    write_signal(outer_state, 1);
+    refresh_system(sys);
+    REQUIRE(outer_runs == 2);
+    REQUIRE(inner_runs == 3);
+
+    // If both need to be refreshed, the inner one is only refreshed once (as
+    // part of the outer one).
+    write_signal(inner_state, 2);
+    write_signal(outer_state, 2);
+    refresh_system(sys);
+    REQUIRE(outer_runs == 3);
+    REQUIRE(inner_runs == 4);
+    REQUIRE(sys.pending_reentries.empty());
+}
+
+TEST_CASE("removed isolated components", "[flow][isolation]")
+{
+    bool active = true;
+    int runs = 0;
+    state_signal<int> state(nullptr);
+
+    alia::system sys;
+    sys.incremental_refresh = true;
+    initialize_system(sys, [&](context ctx) {
+        ALIA_IF(active)
+        {
+            naming_context nc(ctx);
+            named_block nb(nc, make_id(0));
+            invoke_isolated_component(ctx, [&](context ctx) {
+                ++runs;
+                state = get_state(ctx, 0);
+            });
+        }
+        ALIA_END
+    });
+
+    refresh_system(sys);
+    REQUIRE(runs == 1);
+
+    // Request a re-entry and then destroy the component before it happens.
+    write_signal(state, 1);
+    REQUIRE(sys.pending_reentries.size() == 1);
+    active = false;
+    request_full_refresh(sys);
+    refresh_system(sys);
+    REQUIRE(runs == 1);
+    REQUIRE(sys.pending_reentries.empty());
+}
+
+namespace {
+
+struct isolation_test_event
+{
+};
+
+} // namespace
+
+TEST_CASE("isolated component events", "[flow][isolation]")
+{
+    int visits = 0;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        invoke_isolated_component(ctx, [&](context ctx) {
+            isolation_test_event* e;
+            if (detect_event(ctx, &e))
+                ++visits;
+        });
+    });
+
+    refresh_system(sys);
+    isolation_test_event event;
+    detail::dispatch_event(sys, event);
+    REQUIRE(visits == 1);
+}
+
+#ifdef NDEBUG
+
+TEST_CASE("incremental refresh benchmarks", "[flow][isolation]")
+{
+    // 300 isolated components with 100 stateful leaves each
+    int const component_count = 300;
+    int const leaf_count = 100;
+
+    std::vector<std::optional<state_signal<int>>> states(component_count);
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        for (int i = 0; i != component_count; ++i)
+        {
+            invoke_isolated_component(ctx, [&states, i](context ctx) {
+                states[size_t(i)] = get_state(ctx, 0);
+                for (int j = 0; j != leaf_count; ++j)
+                    get_state(ctx, j);
+            });
+        }
+    });
+    refresh_system(sys);
+
+    int n = 0;
+    auto change_one_component = [&]() {
+        ++n;
+        write_signal(*states[size_t(n % component_count)], n);
+    };
+
+    BENCHMARK("30k-component full refresh after one change")
+    {
+        change_one_component();
+        refresh_system(sys);
+    };
+
+    sys.incremental_refresh = true;
+    BENCHMARK("30k-component incremental refresh after one change")
+    {
+        change_one_component();
+        refresh_system(sys);
+    };
+}
+
+#endif
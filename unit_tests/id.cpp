@@ -1,8 +1,12 @@
 #include <alia/id.hpp>
 
 #include <map>
+#include <stdexcept>
+#include <type_traits>
+#include <typeinfo>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <testing.hpp>
 
@@ -16,6 +20,7 @@ test_equal_ids(id_interface const& a, id_interface const& b)
     REQUIRE(b == a);
     REQUIRE(!(a < b));
     REQUIRE(!(b < a));
+    REQUIRE(a.hash() == b.hash());
 }
 
 // Test all the ID operations on a single ID.
@@ -93,6 +98,322 @@ TEST_CASE("captured_id operators", "[id]")
     REQUIRE(c < d);
 }
 
+TEST_CASE("ID hashing", "[id]")
+{
+    // These are all obviously allowed to collide, but if any of these do,
+    // something's very wrong.
+    REQUIRE(make_id(0).hash() != make_id(1).hash());
+    REQUIRE(
+        make_id(std::string("abc")).hash()
+        != make_id(std::string("def")).hash());
+    REQUIRE(
+        combine_ids(make_id(0), make_id(1)).hash()
+        != combine_ids(make_id(1), make_id(0)).hash());
+
+    // IDs that wrap the same value in different ways must agree.
+    int x = 12;
+    REQUIRE(make_id_by_reference(x).hash() == make_id(12).hash());
+    REQUIRE(ref(make_id(12)).hash() == make_id(12).hash());
+
+    // null_id and unit_id have hashes too (even if they aren't very
+    // interesting).
+    REQUIRE(null_id.hash() == null_id.hash());
+    REQUIRE(unit_id.hash() == unit_id.hash());
+}
+
+namespace {
+
+// an ID type that doesn't implement hash()
+struct unhashed_id : id_interface
+{
+    unhashed_id(int value = 0) : value(value)
+    {
+    }
+    id_interface*
+    clone() const override
+    {
+        return new unhashed_id(value);
+    }
+    void
+    deep_copy(id_interface* copy) const override
+    {
+        *static_cast<unhashed_id*>(copy) = *this;
+    }
+    bool
+    equals(id_interface const& other) const override
+    {
+        return value == static_cast<unhashed_id const&>(other).value;
+    }
+    bool
+    less_than(id_interface const& other) const override
+    {
+        return value < static_cast<unhashed_id const&>(other).value;
+    }
+    int value;
+};
+
+} // namespace
+
+TEST_CASE("unhashed IDs", "[id]")
+{
+    test_different_ids(unhashed_id(0), unhashed_id(1));
+    captured_id c(unhashed_id(0));
+    REQUIRE(c.matches(unhashed_id(0)));
+    REQUIRE(!c.matches(unhashed_id(1)));
+}
+
+TEST_CASE("captured_id hashing", "[id]")
+{
+    captured_id c;
+    REQUIRE(c.hash() == 0);
+    c.capture(make_id(1));
+    REQUIRE(c.hash() == make_id(1).hash());
+    REQUIRE(c.matches(make_id(1), make_id(1).hash()));
+    REQUIRE(!c.matches(make_id(2), make_id(2).hash()));
+    captured_id d = c;
+    REQUIRE(d.hash() == c.hash());
+    captured_id e = std::move(d);
+    REQUIRE(e.hash() == c.hash());
+    c.clear();
+    REQUIRE(c.hash() == 0);
+
+    std::unordered_map<captured_id, int> m;
+    m[captured_id(make_id(0))] = 0;
+    m[captured_id(make_id(std::string("abc")))] = 123;
+    m[captured_id(combine_ids(make_id(1), make_id(2)))] = 12;
+    REQUIRE(m.at(captured_id(make_id(0))) == 0);
+    REQUIRE(m.at(captured_id(make_id(std::string("abc")))) == 123);
+    REQUIRE(m.at(captured_id(combine_ids(make_id(1), make_id(2)))) == 12);
+    REQUIRE(m.find(captured_id(make_id(1))) == m.end());
+}
+
+TEST_CASE("captured_id inline storage", "[id]")
+{
+    int x = 2;
+    {
+        captured_id c(make_id(0));
+        REQUIRE(c.is_inline());
+        REQUIRE(c.matches(make_id(0)));
+        c.capture(make_id(1));
+        REQUIRE(c.is_inline());
+        REQUIRE(c.matches(make_id(1)));
+        c.capture(make_id(&x));
+        REQUIRE(c.is_inline());
+        REQUIRE(c.matches(make_id(&x)));
+        c.capture(combine_ids(make_id(1), make_id(2u)));
+        REQUIRE(c.is_inline());
+        REQUIRE(c.matches(combine_ids(make_id(1), make_id(2u))));
+        c.capture(make_id_by_reference(x));
+        REQUIRE(c.is_inline());
+        REQUIRE(c.matches(make_id_by_reference(x)));
+        // The captured value shouldn't depend on the original.
+        x = 3;
+        REQUIRE(!c.matches(make_id_by_reference(x)));
+        int y = 2;
+        REQUIRE(c.matches(make_id_by_reference(y)));
+        c.capture(unit_id);
+        REQUIRE(c.is_inline());
+
+        // Copies and moves of inline IDs are also inline.
+        captured_id d = c;
+        REQUIRE(d.is_inline());
+        REQUIRE(d == c);
+        captured_id e = std::move(d);
+        REQUIRE(e.is_inline());
+        REQUIRE(e == c);
+        REQUIRE(!d.is_initialized());
+        d = c;
+        swap(d, e);
+        REQUIRE(d == c);
+        REQUIRE(e == c);
+    }
+
+    // Larger or non-trivial IDs still go on the heap.
+    captured_id c(make_id(std::string("abc")));
+    REQUIRE(!c.is_inline());
+    REQUIRE(c.matches(make_id(std::string("abc"))));
+    auto big_id = combine_ids(make_id(1), make_id(2), make_id(3), make_id(4));
+    c.capture(big_id);
+    REQUIRE(!c.is_inline());
+    REQUIRE(c.matches(big_id));
+    captured_id d = std::move(c);
+    REQUIRE(d.matches(big_id));
+    d.capture(make_id(0));
+    REQUIRE(d.is_inline());
+}
+
+TEST_CASE("ID type tokens", "[id]")
+{
+    REQUIRE(make_id(0).type_token() == make_id(1).type_token());
+    REQUIRE(make_id(0).type_token() == get_id_type_token<simple_id<int>>());
+    REQUIRE(make_id(0).type_token() != make_id(0u).type_token());
+    int x = 0;
+    REQUIRE(make_id(0).type_token() != make_id_by_reference(x).type_token());
+    REQUIRE(
+        combine_ids(make_id(0), make_id(1)).type_token()
+        == combine_ids(make_id(2), make_id(3)).type_token());
+    REQUIRE(
+        combine_ids(make_id(0), make_id(1)).type_token()
+        != combine_ids(make_id(0), make_id(1u)).type_token());
+    REQUIRE(ref(make_id(0)).type_token() == ref(make_id(0u)).type_token());
+
+    // IDs of different types are never equal, and they're consistently
+    // ordered by type.
+    REQUIRE(make_id(0) != make_id(0u));
+    REQUIRE((make_id(0) < make_id(0u)) != (make_id(0u) < make_id(0)));
+    REQUIRE((make_id(0) < make_id(0u)) == (make_id(1) < make_id(0u)));
+
+    // IDs that rely on the default token still work.
+    REQUIRE(unhashed_id(0).type_token() == unhashed_id(1).type_token());
+    REQUIRE(unhashed_id(0).type_token() != make_id(0).type_token());
+    REQUIRE(unhashed_id(0) != make_id(0));
+}
+
+#ifdef NDEBUG
+
+namespace {
+
+// These replicate the old typeid-based comparisons for reference.
+
+bool
+typeid_equals(id_interface const& a, id_interface const& b)
+{
+    return (typeid(a).name() == typeid(b).name() || typeid(a) == typeid(b))
+           && a.equals(b);
+}
+
+bool
+typeid_less_than(id_interface const& a, id_interface const& b)
+{
+    return typeid(a).before(typeid(b))
+           || ((typeid(a).name() == typeid(b).name() || typeid(a) == typeid(b))
+               && a.less_than(b));
+}
+
+} // namespace
+
+TEST_CASE("ID comparison benchmarks", "[id]")
+{
+    // Compare a mix of same-typed and differently typed IDs.
+    std::vector<std::unique_ptr<id_interface>> ids;
+    for (int i = 0; i != 64; ++i)
+    {
+        switch (i % 4)
+        {
+            case 0:
+                ids.emplace_back(make_id(i).clone());
+                break;
+            case 1:
+                ids.emplace_back(make_id(unsigned(i)).clone());
+                break;
+            case 2:
+                ids.emplace_back(combine_ids(make_id(i), make_id(i)).clone());
+                break;
+            case 3:
+                ids.emplace_back(make_id(std::string("abc")).clone());
+                break;
+        }
+    }
+
+    auto compare_all = [&](auto&& compare) {
+        int count = 0;
+        for (auto const& a : ids)
+        {
+            for (auto const& b : ids)
+            {
+                if (compare(*a, *b))
+                    ++count;
+            }
+        }
+        return count;
+    };
+
+    BENCHMARK("typeid-based ID equality")
+    {
+        return compare_all(typeid_equals);
+    };
+    BENCHMARK("token-based ID equality")
+    {
+        return compare_all(
+            [](id_interface const& a, id_interface const& b) {
+                return a == b;
+            });
+    };
+    BENCHMARK("typeid-based ID ordering")
+    {
+        return compare_all(typeid_less_than);
+    };
+    BENCHMARK("token-based ID ordering")
+    {
+        return compare_all(
+            [](id_interface const& a, id_interface const& b) {
+                return a < b;
+            });
+    };
+}
+
+#endif
+
+namespace {
+
+// This is used to make cloning an ID fail.
+struct unclonable_value
+{
+    explicit unclonable_value(int value) : value(value)
+    {
+    }
+    unclonable_value(unclonable_value const& other) : value(other.value)
+    {
+        if (other.value < 0)
+            throw std::runtime_error("unclonable value");
+    }
+    unclonable_value&
+    operator=(unclonable_value const& other) = default;
+
+    int value;
+};
+bool
+operator==(unclonable_value const& a, unclonable_value const& b)
+{
+    return a.value == b.value;
+}
+bool
+operator<(unclonable_value const& a, unclonable_value const& b)
+{
+    return a.value < b.value;
+}
+
+} // namespace
+
+TEST_CASE("captured_id capture failure", "[id]")
+{
+    // The ID is built by reference, so the copying only happens when it's
+    // captured.
+    unclonable_value bad(-1);
+    auto bad_id = make_id_by_reference(bad);
+
+    // If cloning the new ID fails, the old one is kept, whether it's inline
+    // or on the heap.
+    captured_id c(make_id(1));
+    REQUIRE(c.is_inline());
+    REQUIRE_THROWS_AS(c.capture(bad_id), std::runtime_error);
+    REQUIRE(c == captured_id(make_id(1)));
+    REQUIRE(c.hash() == make_id(1).hash());
+
+    c.capture(make_id(std::string("abc")));
+    REQUIRE(!c.is_inline());
+    REQUIRE_THROWS_AS(c.capture(bad_id), std::runtime_error);
+    REQUIRE(c == captured_id(make_id(std::string("abc"))));
+
+    // Either way, a successful capture still replaces it.
+    unclonable_value good(2);
+    c.capture(make_id_by_reference(good));
+    REQUIRE(c.matches(make_id_by_reference(good)));
+    c.capture(make_id(3));
+    REQUIRE(c.is_inline());
+    REQUIRE(c.matches(make_id(3)));
+}
+
 TEST_CASE("captured_id copy construction", "[id]")
 {
     captured_id c;
@@ -187,6 +508,65 @@ TEST_CASE("combine_ids x4", "[id]")
     test_different_ids(a, b);
 }
 
+TEST_CASE("combine_ids x10", "[id]")
+{
+    auto make_tuple = [](int i) {
+        return combine_ids(
+            make_id(i),
+            make_id(1),
+            make_id(2),
+            make_id(3),
+            make_id(4),
+            make_id(5),
+            make_id(6),
+            make_id(7),
+            make_id(8),
+            make_id(9));
+    };
+    test_different_ids(make_tuple(0), make_tuple(1));
+}
+
+TEST_CASE("flat ID tuples", "[id]")
+{
+    // combine_ids() produces flat tuples.
+    REQUIRE(std::is_same<
+            decltype(combine_ids(make_id(0), make_id(1u), make_id('a'))),
+            id_tuple<simple_id<int>, simple_id<unsigned>, simple_id<char>>>::
+                value);
+    REQUIRE(std::is_same<
+            decltype(combine_ids(make_id(0), make_id(1u))),
+            id_pair<simple_id<int>, simple_id<unsigned>>>::value);
+
+    // Tuples are ordered lexicographically.
+    auto t = [](int a, int b, int c) {
+        return combine_ids(make_id(a), make_id(b), make_id(c));
+    };
+    REQUIRE(t(0, 5, 5) < t(1, 0, 0));
+    REQUIRE(t(1, 0, 5) < t(1, 2, 0));
+    REQUIRE(t(1, 2, 0) < t(1, 2, 3));
+    REQUIRE(!(t(1, 2, 3) < t(1, 2, 3)));
+    REQUIRE(!(t(1, 2, 3) < t(1, 2, 0)));
+    REQUIRE(!(t(1, 2, 3) < t(0, 9, 9)));
+}
+
+TEST_CASE("id_ref copies", "[id]")
+{
+    std::unique_ptr<id_interface> clone;
+    {
+        auto x = make_id(std::string("abc"));
+        clone.reset(alia::ref(x).clone());
+    }
+    // The clone shouldn't depend on the original.
+    REQUIRE(*clone == alia::ref(make_id(std::string("abc"))));
+
+    // Neither should copies of the clone.
+    id_ref copy = static_cast<id_ref const&>(*clone);
+    id_ref moved = std::move(copy);
+    clone.reset();
+    REQUIRE(moved == alia::ref(make_id(std::string("abc"))));
+    REQUIRE(moved.hash() == make_id(std::string("abc")).hash());
+}
+
 TEST_CASE("clone_into/pointer", "[id]")
 {
     id_interface* storage = 0;
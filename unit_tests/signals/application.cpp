@@ -8,6 +8,9 @@
 #include <alia/signals/basic.hpp>
 #include <alia/signals/state.hpp>
 
+#include <stdexcept>
+#include <vector>
+
 #include <flow/testing.hpp>
 #include <traversal.hpp>
 
@@ -334,6 +337,279 @@ TEST_CASE("lift", "[signals][application]")
     }
 }
 
+TEST_CASE("apply_into", "[signals][application]")
+{
+    int f_call_count = 0;
+    auto f = [&](std::vector<int>& result, int n, int x) {
+        ++f_call_count;
+        result.clear();
+        for (int i = 0; i != n; ++i)
+            result.push_back(x + i);
+    };
+
+    captured_id signal_id;
+    int const* storage = nullptr;
+
+    alia::system sys;
+    initialize_system(sys, [](context) {});
+
+    auto make_controller = [&](int n, int x) {
+        return [=, &signal_id, &storage](context ctx) {
+            auto s = apply_into<std::vector<int>>(ctx, f, value(n), value(x));
+
+            typedef decltype(s) signal_t;
+            REQUIRE(signal_is_movable<signal_t>::value);
+            REQUIRE(!signal_is_writable<signal_t>::value);
+
+            REQUIRE(signal_has_value(s));
+            auto const& result = read_signal(s);
+            REQUIRE(result.size() == std::size_t(n));
+            for (int i = 0; i != n; ++i)
+                REQUIRE(result[i] == x + i);
+
+            signal_id.capture(s.value_id());
+            storage = result.data();
+        };
+    };
+
+    do_traversal(sys, make_controller(8, 0));
+    REQUIRE(f_call_count == 1);
+    captured_id last_id = signal_id;
+    int const* original_storage = storage;
+
+    do_traversal(sys, make_controller(8, 0));
+    REQUIRE(f_call_count == 1);
+    REQUIRE(last_id == signal_id);
+
+    // Recomputing reuses the previous result's storage, but the result still
+    // gets a new ID.
+    for (int x = 1; x != 10; ++x)
+    {
+        do_traversal(sys, make_controller(x % 8, x));
+        REQUIRE(last_id != signal_id);
+        last_id = signal_id;
+        REQUIRE(storage == original_storage);
+    }
+    REQUIRE(f_call_count == 10);
+}
+
+TEST_CASE("memoized apply", "[signals][application]")
+{
+    int f_call_count = 0;
+    auto f = [&](int x, int y) {
+        ++f_call_count;
+        return x * 2 + y;
+    };
+
+    captured_id signal_id;
+    memoization_stats stats;
+
+    alia::system sys;
+    initialize_system(sys, [](context) {});
+
+    auto make_controller = [&](auto x) {
+        return [=, &signal_id, &stats](context ctx) {
+            auto s = memoized_apply(ctx, 1, f, x, value(1));
+            if (signal_has_value(x))
+            {
+                REQUIRE(signal_has_value(s));
+                REQUIRE(read_signal(s) == read_signal(x) * 2 + 1);
+            }
+            else
+            {
+                REQUIRE(!signal_has_value(s));
+            }
+            signal_id.capture(s.value_id());
+            stats = s.stats();
+        };
+    };
+
+    do_traversal(sys, make_controller(value(1)));
+    REQUIRE(f_call_count == 1);
+    captured_id last_id = signal_id;
+
+    // Toggling back and forth between two inputs only computes each once.
+    for (int i = 0; i != 4; ++i)
+    {
+        do_traversal(sys, make_controller(value(2)));
+        REQUIRE(last_id != signal_id);
+        last_id = signal_id;
+        do_traversal(sys, make_controller(value(1)));
+        REQUIRE(last_id != signal_id);
+        last_id = signal_id;
+    }
+    REQUIRE(f_call_count == 2);
+    REQUIRE(stats.misses == 2);
+    REQUIRE(stats.hits == 7);
+    REQUIRE(stats.entry_count == 1);
+    REQUIRE(stats.total_cost == 1);
+
+    do_traversal(sys, make_controller(value(1)));
+    REQUIRE(last_id == signal_id);
+
+    // Results survive the inputs being temporarily unavailable.
+    do_traversal(sys, make_controller(empty<int>()));
+    do_traversal(sys, make_controller(value(1)));
+    REQUIRE(f_call_count == 2);
+
+    // Only one previous result is retained, so the oldest one is evicted.
+    do_traversal(sys, make_controller(value(3)));
+    REQUIRE(f_call_count == 3);
+    do_traversal(sys, make_controller(value(2)));
+    REQUIRE(f_call_count == 4);
+    do_traversal(sys, make_controller(value(3)));
+    REQUIRE(f_call_count == 4);
+}
+
+TEST_CASE("memoized apply costs", "[signals][application]")
+{
+    int f_call_count = 0;
+    auto f = [&](int n) {
+        ++f_call_count;
+        return std::string(std::size_t(n), 'x');
+    };
+
+    memoization_stats stats;
+
+    alia::system sys;
+    initialize_system(sys, [](context) {});
+
+    auto make_controller = [&](int n) {
+        return [=, &stats](context ctx) {
+            auto s = memoized_apply(
+                ctx,
+                make_memoization_policy(
+                    10, [](std::string const& s) { return s.size(); }),
+                f,
+                value(n));
+            REQUIRE(read_signal(s) == std::string(std::size_t(n), 'x'));
+            stats = s.stats();
+        };
+    };
+
+    // Results of sizes 4 and 5 both fit.
+    do_traversal(sys, make_controller(4));
+    do_traversal(sys, make_controller(5));
+    do_traversal(sys, make_controller(6));
+    REQUIRE(stats.total_cost == 9);
+    do_traversal(sys, make_controller(4));
+    do_traversal(sys, make_controller(6));
+    REQUIRE(f_call_count == 3);
+
+    // But a result of size 11 never does.
+    do_traversal(sys, make_controller(11));
+    do_traversal(sys, make_controller(4));
+    REQUIRE(stats.entry_count == 0);
+    REQUIRE(stats.total_cost == 0);
+    do_traversal(sys, make_controller(11));
+    REQUIRE(f_call_count == 5);
+}
+
+TEST_CASE("shared apply", "[signals][application]")
+{
+    int f_call_count = 0;
+    auto f = [&](int x) {
+        ++f_call_count;
+        if (x < 0)
+            throw std::runtime_error("negative");
+        return x * 2;
+    };
+
+    alia::system sys;
+    initialize_system(sys, [](context) {});
+    auto& table = get_shared_apply_table(sys);
+
+    int error_count = 0;
+    auto make_controller = [&](bool active, int x, int y) {
+        return [=, &error_count](context ctx) {
+            ALIA_IF(active)
+            {
+                // Three call sites apply f to x, and one applies it to y.
+                for (int i = 0; i != 4; ++i)
+                {
+                    int input = i == 3 ? y : x;
+                    ALIA_TRY
+                    {
+                        auto s = shared_apply(ctx, f, value(input));
+
+                        typedef decltype(s) signal_t;
+                        REQUIRE(!signal_is_movable<signal_t>::value);
+                        REQUIRE(!signal_is_writable<signal_t>::value);
+
+                        REQUIRE(signal_has_value(s));
+                        REQUIRE(read_signal(s) == input * 2);
+                    }
+                    ALIA_CATCH(...)
+                    {
+                        ++error_count;
+                    }
+                    ALIA_END
+                }
+            }
+            ALIA_END
+        };
+    };
+
+    do_traversal(sys, make_controller(true, 1, 2));
+    REQUIRE(f_call_count == 2);
+    REQUIRE(table.entries.size() == 2);
+
+    do_traversal(sys, make_controller(true, 1, 2));
+    REQUIRE(f_call_count == 2);
+
+    // Once nothing uses a result, it's released.
+    do_traversal(sys, make_controller(true, 3, 2));
+    REQUIRE(f_call_count == 3);
+    REQUIRE(table.entries.size() == 2);
+
+    do_traversal(sys, make_controller(true, 2, 2));
+    REQUIRE(f_call_count == 3);
+    REQUIRE(table.entries.size() == 1);
+
+    // Failures are shared too.
+    do_traversal(sys, make_controller(true, -1, 2));
+    REQUIRE(f_call_count == 4);
+    REQUIRE(error_count == 3);
+
+    do_traversal(sys, make_controller(false, -1, 2));
+    REQUIRE(table.entries.empty());
+}
+
+namespace {
+
+int
+double_for_shared_apply(int x)
+{
+    return x * 2;
+}
+
+int
+negate_for_shared_apply(int x)
+{
+    return -x;
+}
+
+} // namespace
+
+TEST_CASE("shared apply with plain functions", "[signals][application]")
+{
+    alia::system sys;
+    initialize_system(sys, [](context) {});
+    auto& table = get_shared_apply_table(sys);
+
+    // These have the same type, so they must be told apart by address.
+    do_traversal(sys, [](context ctx) {
+        auto doubled = shared_apply(ctx, double_for_shared_apply, value(3));
+        auto negated = shared_apply(ctx, negate_for_shared_apply, value(3));
+        REQUIRE(read_signal(doubled) == 6);
+        REQUIRE(read_signal(negated) == -3);
+        auto doubled_again
+            = shared_apply(ctx, &double_for_shared_apply, value(3));
+        REQUIRE(read_signal(doubled_again) == 6);
+    });
+    REQUIRE(table.entries.size() == 2);
+}
+
 TEST_CASE("duplex_apply", "[signals][application]")
 {
     alia::system sys;
@@ -3,9 +3,16 @@
 #include <testing.hpp>
 
 #include <alia/flow/try_catch.hpp>
+#include <alia/signals/application.hpp>
 #include <alia/signals/basic.hpp>
 #include <alia/signals/operators.hpp>
 #include <alia/signals/text.hpp>
+#include <alia/system/internals.hpp>
+
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
 
 #include <traversal.hpp>
 
@@ -70,3 +77,370 @@ TEST_CASE("async", "[signals][async]")
     old_reporter.report_success(1);
     check_traversal(sys, make_controller(2), "0;");
 }
+
+TEST_CASE("async_on_pool", "[signals][async]")
+{
+    thread_pool pool(2);
+
+    int x = 1;
+    int refreshes = 0;
+    std::optional<int> observed;
+    bool failed = false;
+
+    alia::system sys;
+    sys.pool = &pool;
+    initialize_system(sys, [&](context ctx) {
+        if (is_refresh_event(ctx))
+            ++refreshes;
+        ALIA_TRY
+        {
+            auto result = async_on_pool(
+                ctx,
+                [](int x) {
+                    if (x < 0)
+                        throw std::runtime_error("negative");
+                    return x * 2;
+                },
+                value(x));
+            observed = signal_has_value(result)
+                           ? std::optional<int>(read_signal(result))
+                           : std::nullopt;
+        }
+        ALIA_CATCH(...)
+        {
+            failed = true;
+        }
+        ALIA_END
+    });
+
+    refresh_system(sys);
+    REQUIRE(!observed);
+    pool.wait_until_idle();
+    // The result isn't applied until the system's inbox is processed.
+    REQUIRE(!observed);
+    int refreshes_before = refreshes;
+    REQUIRE(process_inbox(sys) == 1);
+    REQUIRE(observed == 2);
+    REQUIRE(refreshes == refreshes_before + 1);
+
+    x = 2;
+    refresh_system(sys);
+    REQUIRE(!observed);
+    pool.wait_until_idle();
+    process_inbox(sys);
+    REQUIRE(observed == 4);
+
+    x = -1;
+    refresh_system(sys);
+    pool.wait_until_idle();
+    process_inbox(sys);
+    REQUIRE(failed);
+}
+
+TEST_CASE("async cancellation", "[signals][async]")
+{
+    bool active = true;
+    int x = 1;
+    std::vector<async_reporter<int>> reporters;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        ALIA_IF(active)
+        {
+            async<int>(
+                ctx,
+                [&](auto, auto reporter, int) {
+                    reporters.push_back(reporter);
+                },
+                value(x));
+        }
+        ALIA_END
+    });
+
+    refresh_system(sys);
+    REQUIRE(reporters.size() == 1);
+    REQUIRE(!reporters[0].is_cancelled());
+
+    // Changing the input cancels the old operation.
+    x = 2;
+    refresh_system(sys);
+    REQUIRE(reporters.size() == 2);
+    REQUIRE(reporters[0].is_cancelled());
+    REQUIRE(!reporters[1].is_cancelled());
+
+    // So does deactivating the component.
+    active = false;
+    refresh_system(sys);
+    REQUIRE(reporters[1].is_cancelled());
+}
+
+TEST_CASE("async_on_pool cancellation", "[signals][async]")
+{
+    thread_pool pool(1);
+
+    // Block the pool's only worker until we're ready.
+    std::mutex gate;
+    std::unique_lock<std::mutex> gate_lock(gate);
+    pool.submit([&] { std::lock_guard<std::mutex> lock(gate); });
+
+    int x = 1;
+    std::atomic<int> invocations{0};
+    std::atomic<int> cancelled_invocations{0};
+    std::optional<int> observed;
+
+    alia::system sys;
+    sys.pool = &pool;
+    initialize_system(sys, [&](context ctx) {
+        auto result = async_on_pool(
+            ctx,
+            [&](cancellation_token token, int x) {
+                ++invocations;
+                if (token.is_cancelled())
+                    ++cancelled_invocations;
+                return x * 2;
+            },
+            value(x));
+        observed = signal_has_value(result)
+                       ? std::optional<int>(read_signal(result))
+                       : std::nullopt;
+    });
+
+    refresh_system(sys);
+    x = 2;
+    refresh_system(sys);
+    x = 3;
+    refresh_system(sys);
+
+    // Only the last operation should actually run.
+    gate_lock.unlock();
+    pool.wait_until_idle();
+    REQUIRE(invocations == 1);
+    REQUIRE(cancelled_invocations == 0);
+    process_inbox(sys);
+    REQUIRE(observed == 6);
+}
+
+TEST_CASE("background_apply", "[signals][async]")
+{
+    thread_pool pool(1);
+
+    int x = 1;
+    std::atomic<int> invocations{0};
+    std::optional<int> observed;
+    bool stale = false;
+    bool failed = false;
+
+    alia::system sys;
+    sys.pool = &pool;
+    initialize_system(sys, [&](context ctx) {
+        failed = false;
+        ALIA_TRY
+        {
+            auto result = background_apply(
+                ctx,
+                [&](int x) {
+                    ++invocations;
+                    if (x < 0)
+                        throw std::runtime_error("negative");
+                    return x * 2;
+                },
+                value(x));
+            observed = signal_has_value(result)
+                           ? std::optional<int>(read_signal(result))
+                           : std::nullopt;
+            stale = result.is_stale();
+        }
+        ALIA_CATCH(...)
+        {
+            failed = true;
+        }
+        ALIA_END
+    });
+
+    refresh_system(sys);
+    REQUIRE(!observed);
+    REQUIRE(!stale);
+    pool.wait_until_idle();
+    REQUIRE(process_inbox(sys) == 1);
+    REQUIRE(observed == 2);
+    REQUIRE(!stale);
+
+    // While the new value is being computed, the old one is still available.
+    std::mutex gate;
+    std::unique_lock<std::mutex> gate_lock(gate);
+    pool.submit([&] { std::lock_guard<std::mutex> lock(gate); });
+    x = 2;
+    refresh_system(sys);
+    REQUIRE(observed == 2);
+    REQUIRE(stale);
+    // If the inputs change again before it's done, the first computation is
+    // dropped.
+    x = 3;
+    refresh_system(sys);
+    REQUIRE(observed == 2);
+    REQUIRE(stale);
+    gate_lock.unlock();
+    pool.wait_until_idle();
+    REQUIRE(invocations == 2);
+    process_inbox(sys);
+    REQUIRE(observed == 6);
+    REQUIRE(!stale);
+
+    x = -1;
+    refresh_system(sys);
+    pool.wait_until_idle();
+    process_inbox(sys);
+    REQUIRE(failed);
+
+    x = 4;
+    refresh_system(sys);
+    REQUIRE(!failed);
+    pool.wait_until_idle();
+    process_inbox(sys);
+    REQUIRE(observed == 8);
+}
+
+#ifdef NDEBUG
+
+TEST_CASE("async_on_pool benchmarks", "[signals][async]")
+{
+    int const signal_count = 5000;
+
+    int generation = 0;
+    int complete_count = 0;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        complete_count = 0;
+        for (int i = 0; i != signal_count; ++i)
+        {
+            auto result = async_on_pool(
+                ctx,
+                [](int n) {
+                    // Do a little bit of work.
+                    unsigned h = unsigned(n);
+                    for (int j = 0; j != 100; ++j)
+                        h = h * 2654435761u + 1;
+                    return h;
+                },
+                value(generation * signal_count + i));
+            if (signal_has_value(result))
+                ++complete_count;
+        }
+    });
+    refresh_system(sys);
+
+    int refreshes = 0;
+    BENCHMARK("5000 concurrent async_on_pool signals")
+    {
+        ++generation;
+        refresh_system(sys);
+        while (complete_count != signal_count)
+        {
+            if (process_inbox(sys) != 0)
+                ++refreshes;
+            else
+                std::this_thread::yield();
+        }
+    };
+    // Completions are applied in batches, so there should be far fewer
+    // refreshes than completions.
+    REQUIRE(refreshes < generation * signal_count);
+}
+
+namespace {
+
+// This can only be moved once. Any further moves throw.
+struct fragile_result
+{
+    fragile_result() = default;
+    explicit fragile_result(int value) : value(value)
+    {
+    }
+    fragile_result(fragile_result&& other) : value(other.value)
+    {
+        if (other.moved)
+            throw std::runtime_error("fragile result moved twice");
+        moved = true;
+    }
+    fragile_result&
+    operator=(fragile_result&& other) = default;
+
+    int value = 0;
+    bool moved = false;
+};
+
+} // namespace
+
+TEST_CASE("background_apply delivery failure", "[signals][async]")
+{
+    thread_pool pool(1);
+
+    bool failed = false;
+
+    alia::system sys;
+    sys.pool = &pool;
+    initialize_system(sys, [&](context ctx) {
+        failed = false;
+        ALIA_TRY
+        {
+            // The result is moved once into the worker's storage, so moving
+            // it into the message for the system fails.
+            background_apply(
+                ctx, [](int x) { return fragile_result(x); }, value(1));
+        }
+        ALIA_CATCH(std::runtime_error&)
+        {
+            failed = true;
+        }
+        ALIA_END
+    });
+
+    refresh_system(sys);
+    REQUIRE(!failed);
+    pool.wait_until_idle();
+    // Nothing was delivered, but the failure is picked up on the next
+    // refresh.
+    REQUIRE(process_inbox(sys) == 0);
+    refresh_system(sys);
+    REQUIRE(failed);
+}
+
+TEST_CASE("background_apply benchmarks", "[signals][async]")
+{
+    // This takes on the order of a millisecond.
+    auto expensive = [](int n) {
+        unsigned h = unsigned(n);
+        for (int j = 0; j != 1000000; ++j)
+            h = h * 2654435761u + 1;
+        return h;
+    };
+
+    int x = 0;
+
+    alia::system apply_sys;
+    initialize_system(apply_sys, [&](context ctx) {
+        apply(ctx, expensive, value(x));
+    });
+    BENCHMARK("refresh with a changing, expensive apply")
+    {
+        ++x;
+        refresh_system(apply_sys);
+    };
+
+    thread_pool pool(1);
+    alia::system background_sys;
+    background_sys.pool = &pool;
+    initialize_system(background_sys, [&](context ctx) {
+        background_apply(ctx, expensive, value(x));
+    });
+    BENCHMARK("refresh with a changing, expensive background_apply")
+    {
+        ++x;
+        refresh_system(background_sys);
+        process_inbox(background_sys);
+    };
+    pool.wait_until_idle();
+}
+
+#endif
@@ -0,0 +1,256 @@
+#include <alia/signals/parallel_apply.hpp>
+
+#include <testing.hpp>
+
+#include <alia/flow/try_catch.hpp>
+#include <alia/signals/basic.hpp>
+#include <alia/system/internals.hpp>
+
+#include <memory>
+#include <stdexcept>
+
+using namespace alia;
+
+TEST_CASE("parallel apply", "[signals][parallel_apply]")
+{
+    thread_pool pool(3);
+
+    int const count = 50;
+    int offset = 0;
+    std::atomic<int> f_call_count{0};
+    auto f = [&](int x) {
+        ++f_call_count;
+        return x * 2;
+    };
+
+    int ready_within_scope = 0;
+    int ready_after_scope = 0;
+
+    alia::system sys;
+    sys.pool = &pool;
+    initialize_system(sys, [&](context ctx) {
+        ready_within_scope = ready_after_scope = 0;
+        std::vector<apply_signal<int>> results;
+        {
+            parallel_apply_scope scope(ctx);
+            for (int i = 0; i != count; ++i)
+            {
+                auto s = parallel_apply(ctx, f, value(offset + i));
+                if (signal_has_value(s))
+                    ++ready_within_scope;
+                results.push_back(s);
+            }
+        }
+        for (int i = 0; i != count; ++i)
+        {
+            if (signal_has_value(results[i]))
+            {
+                REQUIRE(read_signal(results[i]) == (offset + i) * 2);
+                ++ready_after_scope;
+            }
+        }
+    });
+
+    // The results are filled in at the end of the scope, and the components
+    // are refreshed again so that everything sees them.
+    refresh_system(sys);
+    REQUIRE(f_call_count == count);
+    REQUIRE(ready_within_scope == count);
+    REQUIRE(ready_after_scope == count);
+
+    refresh_system(sys);
+    REQUIRE(f_call_count == count);
+
+    offset = 1;
+    refresh_system(sys);
+    REQUIRE(f_call_count == 2 * count);
+    REQUIRE(ready_after_scope == count);
+}
+
+TEST_CASE("failing parallel apply", "[signals][parallel_apply]")
+{
+    thread_pool pool(2);
+
+    int x = 1;
+    int error_count = 0;
+    int ready_count = 0;
+
+    alia::system sys;
+    sys.pool = &pool;
+    initialize_system(sys, [&](context ctx) {
+        error_count = ready_count = 0;
+        parallel_apply_scope scope(ctx);
+        for (int i = 0; i != 4; ++i)
+        {
+            ALIA_TRY
+            {
+                auto s = parallel_apply(
+                    ctx,
+                    [](int x) {
+                        if (x < 0)
+                            throw std::runtime_error("negative");
+                        return x;
+                    },
+                    value(i == 0 ? x : i));
+                if (signal_has_value(s))
+                    ++ready_count;
+            }
+            ALIA_CATCH(...)
+            {
+                ++error_count;
+            }
+            ALIA_END
+        }
+    });
+
+    refresh_system(sys);
+    REQUIRE(error_count == 0);
+    REQUIRE(ready_count == 4);
+
+    // The failure surfaces at the call site, just as it would with apply().
+    x = -1;
+    refresh_system(sys);
+    REQUIRE(error_count == 1);
+    REQUIRE(ready_count == 3);
+}
+
+TEST_CASE("aborted parallel apply", "[signals][parallel_apply]")
+{
+    int f_call_count = 0;
+    bool abort = true;
+    bool ready = false;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        auto& traversal = get_event_traversal(ctx);
+        {
+            parallel_apply_scope scope(ctx);
+            auto s = parallel_apply(
+                ctx,
+                [&](int x) {
+                    ++f_call_count;
+                    return x + 1;
+                },
+                value(1));
+            ready = signal_has_value(s);
+            // Simulate an (exception-free) abortion of the traversal.
+            traversal.aborted = abort;
+        }
+        traversal.aborted = false;
+    });
+
+    // The computation is dropped rather than run at the join point.
+    refresh_system(sys);
+    REQUIRE(f_call_count == 0);
+    REQUIRE(!ready);
+
+    abort = false;
+    refresh_system(sys);
+    REQUIRE(f_call_count == 1);
+}
+
+namespace {
+
+struct abort_event
+{
+};
+
+} // namespace
+
+TEST_CASE("parallel apply abortion", "[signals][parallel_apply]")
+{
+    bool ran = false;
+    std::weak_ptr<int> captured;
+    bool released_on_abort = false;
+
+    alia::system sys;
+    sys.exception_free_abortion = true;
+    initialize_system(sys, [&](context ctx) {
+        if (is_refresh_event(ctx))
+            return;
+        parallel_apply_scope outer(ctx);
+        auto state = std::make_shared<int>(0);
+        captured = state;
+        outer.defer(
+            [&ran, state] { ran = true; },
+            get_active_component_container(ctx));
+        state.reset();
+        {
+            parallel_apply_scope inner(ctx);
+            inner.defer(
+                [&ran] { ran = true; }, get_active_component_container(ctx));
+            // Aborting the traversal discards the deferred work in all the
+            // active scopes right away (releasing whatever it captured).
+            abort_traversal(ctx);
+            released_on_abort = captured.expired();
+        }
+    });
+
+    refresh_system(sys);
+    abort_event event;
+    dispatch_event(sys, event);
+    REQUIRE(released_on_abort);
+    REQUIRE(!ran);
+}
+
+TEST_CASE("parallel apply without a scope", "[signals][parallel_apply]")
+{
+    int f_call_count = 0;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        auto s = parallel_apply(
+            ctx,
+            [&](int x) {
+                ++f_call_count;
+                return x + 1;
+            },
+            value(1));
+        // Without a scope, this is computed on the spot.
+        REQUIRE(read_signal(s) == 2);
+    });
+    refresh_system(sys);
+    REQUIRE(f_call_count == 1);
+}
+
+#ifdef NDEBUG
+
+TEST_CASE("parallel apply benchmarks", "[signals][parallel_apply]")
+{
+    int const column_count = 500;
+
+    // This takes on the order of tens of microseconds.
+    auto derive = [](int n) {
+        unsigned h = unsigned(n);
+        for (int j = 0; j != 20000; ++j)
+            h = h * 2654435761u + 1;
+        return h;
+    };
+
+    int generation = 0;
+
+    alia::system serial_sys;
+    initialize_system(serial_sys, [&](context ctx) {
+        for (int i = 0; i != column_count; ++i)
+            apply(ctx, derive, value(generation * column_count + i));
+    });
+    BENCHMARK("500 serial applies")
+    {
+        ++generation;
+        refresh_system(serial_sys);
+    };
+
+    alia::system parallel_sys;
+    initialize_system(parallel_sys, [&](context ctx) {
+        parallel_apply_scope scope(ctx);
+        for (int i = 0; i != column_count; ++i)
+            parallel_apply(ctx, derive, value(generation * column_count + i));
+    });
+    BENCHMARK("500 parallel applies")
+    {
+        ++generation;
+        refresh_system(parallel_sys);
+    };
+}
+
+#endif
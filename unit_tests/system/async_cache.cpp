@@ -0,0 +1,347 @@
+#include <alia/system/async_cache.hpp>
+
+#include <testing.hpp>
+
+#include <alia/flow/macros.hpp>
+#include <alia/flow/try_catch.hpp>
+#include <alia/signals/async.hpp>
+#include <alia/signals/basic.hpp>
+#include <alia/system/internals.hpp>
+
+#include <optional>
+#include <stdexcept>
+
+using namespace alia;
+
+namespace {
+
+struct async_cache_external_interface : default_external_interface
+{
+    async_cache_external_interface(alia::system& sys)
+        : default_external_interface(sys)
+    {
+    }
+
+    millisecond_count tick_count = 0;
+
+    millisecond_count
+    get_tick_count() const
+    {
+        return tick_count;
+    }
+};
+
+// This keeps track of the operations that the tests' launcher has been asked
+// to start.
+struct launch_log
+{
+    std::vector<int> inputs;
+    std::vector<async_reporter<int>> reporters;
+};
+
+// This runs :row_count rows that each request :key(row) from a shared
+// launcher that records its operations in :log. The results are written to
+// :results.
+template<class Key>
+auto
+make_row_controller(
+    launch_log& log,
+    int& row_count,
+    Key key,
+    std::vector<std::optional<int>>& results)
+{
+    return [&log, &row_count, key, &results](context ctx) {
+        auto launcher = [&log](auto, auto reporter, int x) {
+            log.inputs.push_back(x);
+            log.reporters.push_back(reporter);
+        };
+        results.resize(row_count);
+        ALIA_FOR(int i = 0; i != row_count; ++i)
+        {
+            ALIA_TRY
+            {
+                auto result
+                    = shared_async<int>(ctx, launcher, value(key(i)));
+                results[i] = signal_has_value(result)
+                                 ? std::optional<int>(read_signal(result))
+                                 : std::nullopt;
+            }
+            ALIA_CATCH(...)
+            {
+                results[i] = -1;
+            }
+            ALIA_END
+        }
+        ALIA_END
+    };
+}
+
+} // namespace
+
+namespace {
+
+// the results that the plain launchers below have been asked to report
+std::vector<std::pair<async_reporter<int>, int>> plain_launcher_results;
+
+void
+launch_doubling(dataless_context, async_reporter<int> reporter, int x)
+{
+    plain_launcher_results.emplace_back(reporter, x * 2);
+}
+
+void
+launch_negation(dataless_context, async_reporter<int> reporter, int x)
+{
+    plain_launcher_results.emplace_back(reporter, -x);
+}
+
+} // namespace
+
+TEST_CASE("shared async with plain launchers", "[system][async_cache]")
+{
+    std::optional<int> doubled, negated;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        // These have the same type, so they must be told apart by address.
+        auto a = shared_async<int>(ctx, launch_doubling, value(3));
+        auto b = shared_async<int>(ctx, launch_negation, value(3));
+        doubled = signal_has_value(a) ? std::optional<int>(read_signal(a))
+                                      : std::nullopt;
+        negated = signal_has_value(b) ? std::optional<int>(read_signal(b))
+                                      : std::nullopt;
+    });
+
+    plain_launcher_results.clear();
+    refresh_system(sys);
+    REQUIRE(get_async_cache(sys).entries.size() == 2);
+    REQUIRE(plain_launcher_results.size() == 2);
+    for (auto& [reporter, result] : plain_launcher_results)
+        reporter.report_success(result);
+    plain_launcher_results.clear();
+    REQUIRE(doubled == 6);
+    REQUIRE(negated == -3);
+}
+
+TEST_CASE("shared async", "[system][async_cache]")
+{
+    launch_log log;
+    int row_count = 50;
+    std::vector<std::optional<int>> results;
+
+    alia::system sys;
+    initialize_system(
+        sys,
+        make_row_controller(
+            log, row_count, [](int) { return 7; }, results));
+    auto& cache = get_async_cache(sys);
+
+    // All fifty rows share one operation.
+    refresh_system(sys);
+    REQUIRE(log.inputs == std::vector<int>{7});
+    REQUIRE(cache.entries.size() == 1);
+    for (auto const& result : results)
+        REQUIRE(!result);
+
+    // And the result is delivered to all of them.
+    log.reporters[0].report_success(14);
+    for (auto const& result : results)
+        REQUIRE(result == 14);
+    refresh_system(sys);
+    REQUIRE(log.inputs.size() == 1);
+}
+
+TEST_CASE("shared async with distinct keys", "[system][async_cache]")
+{
+    launch_log log;
+    int row_count = 9;
+    std::vector<std::optional<int>> results;
+
+    alia::system sys;
+    initialize_system(
+        sys,
+        make_row_controller(
+            log, row_count, [](int i) { return i % 3; }, results));
+    auto& cache = get_async_cache(sys);
+
+    refresh_system(sys);
+    REQUIRE(log.inputs == std::vector<int>{0, 1, 2});
+    REQUIRE(cache.entries.size() == 3);
+
+    // Only the rows that requested 1 see its result.
+    log.reporters[1].report_success(10);
+    for (int i = 0; i != row_count; ++i)
+    {
+        if (i % 3 == 1)
+            REQUIRE(results[i] == 10);
+        else
+            REQUIRE(!results[i]);
+    }
+
+    // Failures are shared as well.
+    log.reporters[2].report_failure(
+        std::make_exception_ptr(std::runtime_error("failed")));
+    for (int i = 0; i != row_count; ++i)
+    {
+        if (i % 3 == 2)
+            REQUIRE(results[i] == -1);
+    }
+}
+
+TEST_CASE("shared async retention", "[system][async_cache]")
+{
+    launch_log log;
+    int row_count = 2;
+    int offset = 0;
+    std::vector<std::optional<int>> results;
+
+    alia::system sys;
+    initialize_system(
+        sys,
+        make_row_controller(
+            log, row_count, [&](int i) { return offset + i; }, results));
+    auto& cache = get_async_cache(sys);
+
+    refresh_system(sys);
+    REQUIRE(log.inputs == std::vector<int>{0, 1});
+    log.reporters[0].report_success(0);
+
+    // Once nothing references them, the entries are retained.
+    row_count = 0;
+    refresh_system(sys);
+    REQUIRE(cache.entries.size() == 2);
+    REQUIRE(cache.unreferenced.size() == 2);
+    REQUIRE(!log.reporters[1].is_cancelled());
+
+    // So they can be picked up again without relaunching.
+    row_count = 2;
+    refresh_system(sys);
+    REQUIRE(log.inputs.size() == 2);
+    REQUIRE(results[0] == 0);
+    REQUIRE(!results[1]);
+    REQUIRE(cache.unreferenced.empty());
+    log.reporters[1].report_success(1);
+    REQUIRE(results[1] == 1);
+
+    // Failed results aren't retained.
+    offset = 2;
+    refresh_system(sys);
+    REQUIRE(log.inputs == std::vector<int>{0, 1, 2, 3});
+    log.reporters[2].report_failure(
+        std::make_exception_ptr(std::runtime_error("failed")));
+    REQUIRE(results[0] == -1);
+    offset = 4;
+    refresh_system(sys);
+    REQUIRE(cache.entries.size() == 5);
+    offset = 2;
+    refresh_system(sys);
+    REQUIRE(log.inputs == std::vector<int>{0, 1, 2, 3, 4, 5, 2});
+}
+
+TEST_CASE("shared async size eviction", "[system][async_cache]")
+{
+    launch_log log;
+    int row_count = 1;
+    int key = 0;
+    std::vector<std::optional<int>> results;
+
+    alia::system sys;
+    initialize_system(
+        sys,
+        make_row_controller(
+            log, row_count, [&](int) { return key; }, results));
+    auto& cache = get_async_cache(sys);
+    cache.max_unreferenced_entries = 2;
+
+    for (key = 0; key != 4; ++key)
+        refresh_system(sys);
+    REQUIRE(log.inputs == std::vector<int>{0, 1, 2, 3});
+
+    // Only the two most recently released entries are retained, and evicting
+    // the oldest one cancelled its operation.
+    REQUIRE(cache.entries.size() == 3);
+    REQUIRE(log.reporters[0].is_cancelled());
+    REQUIRE(!log.reporters[1].is_cancelled());
+    REQUIRE(!log.reporters[2].is_cancelled());
+
+    key = 0;
+    refresh_system(sys);
+    REQUIRE(log.inputs.size() == 5);
+    key = 2;
+    refresh_system(sys);
+    REQUIRE(log.inputs.size() == 5);
+}
+
+TEST_CASE("shared async expiration", "[system][async_cache]")
+{
+    launch_log log;
+    int row_count = 1;
+    std::vector<std::optional<int>> results;
+
+    alia::system sys;
+    auto* external = new async_cache_external_interface(sys);
+    initialize_system(
+        sys,
+        make_row_controller(
+            log, row_count, [](int) { return 0; }, results),
+        external);
+    auto& cache = get_async_cache(sys);
+    cache.max_unreferenced_age = 1000;
+
+    refresh_system(sys);
+    log.reporters[0].report_success(1);
+
+    row_count = 0;
+    refresh_system(sys);
+    REQUIRE(cache.entries.size() == 1);
+
+    external->tick_count = 1000;
+    refresh_system(sys);
+    REQUIRE(cache.entries.size() == 1);
+
+    external->tick_count = 1001;
+    refresh_system(sys);
+    REQUIRE(cache.entries.empty());
+
+    row_count = 1;
+    refresh_system(sys);
+    REQUIRE(log.inputs.size() == 2);
+}
+
+#ifdef NDEBUG
+
+TEST_CASE("shared async benchmarks", "[system][async_cache]")
+{
+    int const row_count = 50;
+
+    int generation = 0;
+    int complete_count = 0;
+    std::vector<async_reporter<int>> reporters;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        complete_count = 0;
+        for (int i = 0; i != row_count; ++i)
+        {
+            auto result = shared_async<int>(
+                ctx,
+                [&](auto, auto reporter, int) {
+                    reporters.push_back(reporter);
+                },
+                value(generation));
+            if (signal_has_value(result))
+                ++complete_count;
+        }
+    });
+
+    BENCHMARK("50 rows sharing an async request")
+    {
+        ++generation;
+        refresh_system(sys);
+        reporters.back().report_success(generation);
+    };
+    REQUIRE(complete_count == row_count);
+    REQUIRE(int(reporters.size()) == generation);
+}
+
+#endif
@@ -0,0 +1,215 @@
+#include <alia/system/async_scheduler.hpp>
+
+#include <testing.hpp>
+
+#include <alia/flow/macros.hpp>
+#include <alia/signals/async.hpp>
+#include <alia/signals/basic.hpp>
+#include <alia/system/internals.hpp>
+
+#include <map>
+#include <optional>
+
+using namespace alia;
+
+namespace {
+
+struct async_scheduler_external_interface : default_external_interface
+{
+    async_scheduler_external_interface(alia::system& sys)
+        : default_external_interface(sys)
+    {
+    }
+
+    millisecond_count tick_count = 0;
+
+    millisecond_count
+    get_tick_count() const
+    {
+        return tick_count;
+    }
+};
+
+// the state of a set of rows that each run an async operation
+struct row_state
+{
+    std::vector<async_priority> priorities;
+    std::vector<bool> active;
+    // the rows whose operations have been launched, in order
+    std::vector<int> launched;
+    std::map<int, async_reporter<int>> reporters;
+    std::vector<std::optional<int>> results;
+
+    explicit row_state(int row_count)
+        : priorities(row_count, async_priority::NORMAL),
+          active(row_count, true),
+          results(row_count)
+    {
+    }
+};
+
+std::function<void(context)>
+make_row_controller(row_state& rows)
+{
+    return [&rows](context ctx) {
+        ALIA_FOR(int i = 0; i != int(rows.priorities.size()); ++i)
+        {
+            ALIA_IF(rows.active[i])
+            {
+                auto result = prioritized_async<int>(
+                    ctx,
+                    rows.priorities[i],
+                    [&rows](auto, auto reporter, int row) {
+                        rows.launched.push_back(row);
+                        rows.reporters[row] = reporter;
+                    },
+                    value(i));
+                rows.results[i] = signal_has_value(result)
+                                      ? std::optional<int>(read_signal(result))
+                                      : std::nullopt;
+            }
+            ALIA_END
+        }
+        ALIA_END
+    };
+}
+
+} // namespace
+
+TEST_CASE("async concurrency limits", "[system][async_scheduler]")
+{
+    row_state rows(5);
+
+    alia::system sys;
+    auto* external = new async_scheduler_external_interface(sys);
+    initialize_system(sys, make_row_controller(rows), external);
+    set_async_concurrency_limit(sys, 2);
+
+    refresh_system(sys);
+    REQUIRE(rows.launched == std::vector<int>{0, 1});
+    auto const& stats = get_async_priority_stats(sys, async_priority::NORMAL);
+    REQUIRE(stats.queue_depth == 3);
+    REQUIRE(stats.peak_queue_depth == 3);
+    REQUIRE(stats.launches == 2);
+    REQUIRE(stats.total_wait == 0);
+
+    // Completing an operation frees up its slot for the next one.
+    external->tick_count = 10;
+    rows.reporters[0].report_success(0);
+    REQUIRE(rows.results[0] == 0);
+    REQUIRE(rows.launched == std::vector<int>{0, 1, 2});
+    REQUIRE(stats.queue_depth == 2);
+    REQUIRE(stats.launches == 3);
+    REQUIRE(stats.total_wait == 10);
+    REQUIRE(stats.max_wait == 10);
+
+    external->tick_count = 30;
+    rows.reporters[1].report_success(1);
+    rows.reporters[2].report_success(2);
+    REQUIRE(rows.launched == std::vector<int>{0, 1, 2, 3, 4});
+    REQUIRE(stats.queue_depth == 0);
+    REQUIRE(stats.total_wait == 70);
+    REQUIRE(stats.max_wait == 30);
+    REQUIRE(get_async_scheduler(sys).active_count == 2);
+
+    rows.reporters[3].report_success(3);
+    rows.reporters[4].report_success(4);
+    REQUIRE(get_async_scheduler(sys).active_count == 0);
+    for (int i = 0; i != 5; ++i)
+        REQUIRE(rows.results[i] == i);
+}
+
+TEST_CASE("async priorities", "[system][async_scheduler]")
+{
+    row_state rows(5);
+    rows.priorities[4] = async_priority::LOW;
+
+    alia::system sys;
+    initialize_system(sys, make_row_controller(rows));
+    set_async_concurrency_limit(sys, 1);
+
+    refresh_system(sys);
+    REQUIRE(rows.launched == std::vector<int>{0});
+    REQUIRE(
+        get_async_priority_stats(sys, async_priority::NORMAL).queue_depth
+        == 3);
+    REQUIRE(
+        get_async_priority_stats(sys, async_priority::LOW).queue_depth == 1);
+
+    // Re-prioritize some of the waiting requests.
+    rows.priorities[3] = async_priority::HIGH;
+    rows.priorities[4] = async_priority::HIGH;
+    rows.priorities[1] = async_priority::LOW;
+    refresh_system(sys);
+    REQUIRE(
+        get_async_priority_stats(sys, async_priority::HIGH).queue_depth == 2);
+
+    std::vector<int> expected_order = {0, 3, 4, 2, 1};
+    for (int i = 0; i != 4; ++i)
+        rows.reporters[expected_order[i]].report_success(0);
+    REQUIRE(rows.launched == expected_order);
+}
+
+TEST_CASE("async scheduler releases", "[system][async_scheduler]")
+{
+    row_state rows(4);
+
+    alia::system sys;
+    initialize_system(sys, make_row_controller(rows));
+    set_async_concurrency_limit(sys, 1);
+
+    refresh_system(sys);
+    REQUIRE(rows.launched == std::vector<int>{0});
+
+    // Deactivating a running operation frees up its slot.
+    rows.active[0] = false;
+    refresh_system(sys);
+    REQUIRE(rows.reporters[0].is_cancelled());
+    REQUIRE(rows.launched == std::vector<int>{0, 1});
+
+    // Deactivating a waiting operation removes it from the queue.
+    rows.active[2] = false;
+    refresh_system(sys);
+    REQUIRE(
+        get_async_priority_stats(sys, async_priority::NORMAL).queue_depth
+        == 1);
+
+    // Raising the limit lets the rest launch.
+    rows.active[0] = true;
+    set_async_concurrency_limit(sys, 0);
+    refresh_system(sys);
+    REQUIRE(rows.launched == std::vector<int>{0, 1, 0, 3});
+}
+
+#ifdef NDEBUG
+
+TEST_CASE("async scheduler benchmarks", "[system][async_scheduler]")
+{
+    int const row_count = 2000;
+
+    row_state rows(row_count);
+
+    alia::system sys;
+    initialize_system(sys, make_row_controller(rows));
+    set_async_concurrency_limit(sys, 16);
+    refresh_system(sys);
+
+    BENCHMARK("2000 queued async requests, 16 at a time")
+    {
+        // Complete the operations that are running and launch the next batch.
+        auto running = std::move(rows.reporters);
+        rows.reporters.clear();
+        for (auto& [row, reporter] : running)
+            reporter.report_success(row);
+        if (rows.reporters.empty())
+        {
+            // Everything is done, so start over.
+            rows.active.assign(row_count, false);
+            refresh_system(sys);
+            rows.active.assign(row_count, true);
+            refresh_system(sys);
+        }
+    };
+}
+
+#endif
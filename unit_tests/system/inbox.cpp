@@ -0,0 +1,103 @@
+#include <alia/system/inbox.hpp>
+
+#include <testing.hpp>
+
+#include <alia/system/internals.hpp>
+
+#include <thread>
+
+using namespace alia;
+using std::string;
+
+namespace {
+
+struct inbox_test_event
+{
+    int n;
+};
+
+} // namespace
+
+TEST_CASE("inbox delivery", "[system][inbox]")
+{
+    string log;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        event_handler<inbox_test_event>(ctx, [&](auto, inbox_test_event& e) {
+            log += "event" + std::to_string(e.n) + ";";
+        });
+    });
+    refresh_system(sys);
+
+    REQUIRE(!inbox_is_monitored(sys));
+    REQUIRE(drain_inbox(sys.inbox, sys) == 0);
+
+    post_to_system(sys, [&](alia::system&) { log += "a;"; });
+    post_event(sys, inbox_test_event{1});
+    post_to_system(sys, [&](alia::system&) { log += "b;"; });
+    REQUIRE(log == "");
+
+    // Posted functions run as they're drained, while posted events are
+    // queued for the next batch.
+    REQUIRE(drain_inbox(sys.inbox, sys) == 3);
+    REQUIRE(log == "a;b;");
+    process_event_batch(sys);
+    REQUIRE(log == "a;b;event1;");
+}
+
+TEST_CASE("inbox exceptions", "[system][inbox]")
+{
+    string log;
+
+    alia::system sys;
+    initialize_system(sys, [](context) {});
+
+    post_to_system(sys, [&](alia::system&) { log += "a;"; });
+    post_to_system(sys, [&](alia::system&) { throw 0; });
+    post_to_system(sys, [&](alia::system&) { log += "b;"; });
+    REQUIRE_THROWS(drain_inbox(sys.inbox, sys));
+    REQUIRE(log == "a;");
+
+    // The messages after the failed one are delivered by the next drain,
+    // before newer ones.
+    post_to_system(sys, [&](alia::system&) { log += "c;"; });
+    REQUIRE(drain_inbox(sys.inbox, sys) == 2);
+    REQUIRE(log == "a;b;c;");
+}
+
+TEST_CASE("multithreaded inbox", "[system][inbox]")
+{
+    int const thread_count = 4;
+    int const messages_per_thread = 1000;
+
+    alia::system sys;
+    initialize_system(sys, [](context) {});
+
+    std::vector<int> last_received(thread_count, -1);
+    bool in_order = true;
+    int received = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t != thread_count; ++t)
+    {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i != messages_per_thread; ++i)
+            {
+                post_to_system(sys, [&, t, i](alia::system&) {
+                    if (last_received[t] != i - 1)
+                        in_order = false;
+                    last_received[t] = i;
+                    ++received;
+                });
+            }
+        });
+    }
+    while (received != thread_count * messages_per_thread)
+        drain_inbox(sys.inbox, sys);
+    for (auto& thread : threads)
+        thread.join();
+
+    REQUIRE(in_order);
+    REQUIRE(drain_inbox(sys.inbox, sys) == 0);
+}
@@ -0,0 +1,187 @@
+#ifdef __linux__
+
+#include <alia/system/run_loop.hpp>
+
+#include <testing.hpp>
+
+#include <alia/signals/async.hpp>
+#include <alia/signals/basic.hpp>
+#include <alia/signals/operators.hpp>
+#include <alia/timing/timer.hpp>
+
+#include <atomic>
+#include <thread>
+
+using namespace alia;
+
+namespace {
+
+struct increment_event
+{
+};
+
+} // namespace
+
+TEST_CASE("run loop events", "[system][run_loop]")
+{
+    int const thread_count = 4;
+    int const events_per_thread = 100;
+
+    int total = 0;
+    int refreshes = 0;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        if (is_refresh_event(ctx))
+            ++refreshes;
+        event_handler<increment_event>(
+            ctx, [&](auto, increment_event&) { ++total; });
+    });
+    refresh_system(sys);
+
+    run_loop loop(sys);
+    REQUIRE(inbox_is_monitored(sys));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t != thread_count; ++t)
+    {
+        threads.emplace_back([&] {
+            for (int i = 0; i != events_per_thread; ++i)
+                post_event(sys, increment_event());
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    // Once everything has been delivered, stop the loop.
+    post_to_system(sys, [&](alia::system&) { loop.stop(); });
+
+    int refreshes_before = refreshes;
+    loop.run();
+    REQUIRE(total == thread_count * events_per_thread);
+    // The events were drained in batches, so there should be far fewer
+    // refreshes than events.
+    REQUIRE(refreshes - refreshes_before < thread_count * events_per_thread);
+}
+
+TEST_CASE("run loop stopping", "[system][run_loop]")
+{
+    alia::system sys;
+    initialize_system(sys, [](context) {});
+    refresh_system(sys);
+
+    run_loop loop(sys);
+    std::thread stopper([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        loop.stop();
+    });
+    loop.run();
+    stopper.join();
+
+    // With nothing to do, run_once() just times out.
+    loop.run_once(1);
+}
+
+TEST_CASE("run loop teardown while posting", "[system][run_loop]")
+{
+    alia::system sys;
+    initialize_system(sys, [](context) {});
+    refresh_system(sys);
+
+    // Run loops come and go while another thread is posting, so the poster
+    // is regularly waking a loop that's in the middle of being destroyed.
+    std::atomic<bool> done{false};
+    std::thread poster([&] {
+        while (!done)
+        {
+            post_to_system(sys, [](alia::system&) {});
+            std::this_thread::yield();
+        }
+    });
+    for (int i = 0; i != 200; ++i)
+    {
+        run_loop loop(sys);
+        loop.run_once(0);
+    }
+    REQUIRE(!inbox_is_monitored(sys));
+    done = true;
+    poster.join();
+    process_inbox(sys);
+}
+
+TEST_CASE("run loop with messages already posted", "[system][run_loop]")
+{
+    alia::system sys;
+    initialize_system(sys, [](context) {});
+    refresh_system(sys);
+
+    // Messages that are posted while no run loop is attached can't wake one
+    // up, so the run loop has to notice them itself when it's constructed.
+    // (Otherwise, run_once() would wait forever here.)
+    int delivered = 0;
+    post_to_system(sys, [&](alia::system&) { ++delivered; });
+    {
+        run_loop loop(sys);
+        loop.run_once();
+        REQUIRE(delivered == 1);
+    }
+
+    // The same goes for messages that arrive between run loops.
+    post_to_system(sys, [&](alia::system&) { ++delivered; });
+    {
+        run_loop loop(sys);
+        loop.run_once();
+        REQUIRE(delivered == 2);
+    }
+}
+
+TEST_CASE("run loop timers", "[system][run_loop]")
+{
+    bool fired = false;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        timer t(ctx);
+        if (t.is_triggered())
+            fired = true;
+        else if (!t.is_active() && !fired)
+            t.start(5);
+    });
+    refresh_system(sys);
+
+    run_loop loop(sys);
+    for (int i = 0; i != 100 && !fired; ++i)
+        loop.run_once(1000);
+    REQUIRE(fired);
+}
+
+TEST_CASE("run loop async completions", "[system][run_loop]")
+{
+    std::thread worker;
+    int observed = 0;
+
+    alia::system sys;
+    initialize_system(sys, [&](context ctx) {
+        auto result = async<int>(
+            ctx,
+            [&](auto, auto reporter, int x) {
+                worker = std::thread([reporter, x] {
+                    // This is safe to call from here because the system is
+                    // being driven by a run loop.
+                    reporter.report_success(x * 2);
+                });
+            },
+            value(21));
+        if (signal_has_value(result))
+            observed = read_signal(result);
+    });
+
+    run_loop loop(sys);
+    refresh_system(sys);
+    worker.join();
+    REQUIRE(observed == 0);
+
+    loop.run_once(1000);
+    REQUIRE(observed == 42);
+}
+
+#endif
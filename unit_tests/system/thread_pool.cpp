@@ -0,0 +1,105 @@
+#include <alia/system/thread_pool.hpp>
+
+#include <alia/system/internals.hpp>
+
+#include <testing.hpp>
+
+using namespace alia;
+
+TEST_CASE("thread pool", "[system][thread_pool]")
+{
+    thread_pool pool(4);
+    REQUIRE(pool.size() == 4);
+
+    std::atomic<int> count{0};
+    for (int i = 0; i != 1000; ++i)
+        pool.submit([&] { ++count; });
+    pool.wait_until_idle();
+    REQUIRE(count == 1000);
+
+}
+
+TEST_CASE("thread pool errors", "[system][thread_pool]")
+{
+    thread_pool pool(2);
+
+    // Exceptions are passed to the error handler, and they don't take down
+    // the workers.
+    std::atomic<int> error_count{0};
+    pool.set_error_handler([&](std::exception_ptr error) {
+        try
+        {
+            std::rethrow_exception(error);
+        }
+        catch (int)
+        {
+            ++error_count;
+        }
+    });
+    std::atomic<int> count{0};
+    for (int i = 0; i != 10; ++i)
+    {
+        pool.submit([] { throw 0; });
+        pool.submit([&] { ++count; });
+    }
+    pool.wait_until_idle();
+    REQUIRE(error_count == 10);
+    REQUIRE(count == 10);
+}
+
+TEST_CASE("nested thread pool tasks", "[system][thread_pool]")
+{
+    thread_pool pool(3);
+
+    // Each task spawns two more until the tree is 10 levels deep, which
+    // leaves plenty of work for the other workers to steal.
+    std::atomic<int> count{0};
+    std::function<void(int)> spawn = [&](int depth) {
+        ++count;
+        if (depth != 0)
+        {
+            pool.submit([&, depth] { spawn(depth - 1); });
+            pool.submit([&, depth] { spawn(depth - 1); });
+        }
+    };
+    pool.submit([&] { spawn(9); });
+    pool.wait_until_idle();
+    REQUIRE(count == 1023);
+}
+
+TEST_CASE("thread pool shutdown", "[system][thread_pool]")
+{
+    std::atomic<int> count{0};
+    {
+        thread_pool pool(2);
+        for (int i = 0; i != 100; ++i)
+            pool.submit([&] { ++count; });
+    }
+    // Queued tasks are finished before the pool is destroyed.
+    REQUIRE(count == 100);
+}
+
+TEST_CASE("default thread pool lifetime", "[system][thread_pool]")
+{
+    std::weak_ptr<thread_pool> default_pool;
+    {
+        alia::system a, b;
+        initialize_system(a, [](context) {});
+        initialize_system(b, [](context) {});
+
+        // Systems share the default pool.
+        thread_pool& pool = get_thread_pool(a);
+        REQUIRE(&get_thread_pool(b) == &pool);
+        default_pool = a.default_pool;
+
+        // Systems with their own pools don't use it.
+        thread_pool own_pool(1);
+        alia::system c;
+        initialize_system(c, [](context) {});
+        c.pool = &own_pool;
+        REQUIRE(&get_thread_pool(c) == &own_pool);
+        REQUIRE(!c.default_pool);
+    }
+    // Once the systems are gone, so is the default pool.
+    REQUIRE(default_pool.expired());
+}